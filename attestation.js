@@ -0,0 +1,214 @@
+
+/**
+ * STFU GameGuardian attestation validator
+ *
+ * Issues single-use nonces and checks the client's answer against reference
+ * images of the native library and the attested assets. The protocol is
+ * documented in src/lib/memoryGuard/Attestation.h; with HMAC = HMAC-SHA256
+ * keyed by the nonce:
+ *  - targets are cut into 4 KiB chunks, numbered across targets 0..N-1
+ *  - pick i (of 32) is word i % 8 of HMAC(u32be(i / 8)), big-endian, mod N
+ *  - response = HMAC(u32be(pick_0) || HMAC(chunk_0) || ... pick_31 || HMAC(chunk_31))
+ *
+ * The client stops working at the deadline it is given, but a hooked client
+ * could ignore that and compute the answer from an unpatched copy of the
+ * library, so the server also times each challenge: a response arriving
+ * later than the deadline plus a network round-trip allowance fails.
+ *
+ * Chunk tables are built once at startup as views into the loaded images, so
+ * a verification is 37 small HMACs over at most 128 KiB and no allocation
+ * beyond the transcript.
+ */
+
+const crypto = require('crypto');
+const fs = require('fs');
+const { performance } = require('perf_hooks');
+
+const NONCE_SIZE = 32;
+const CHUNK_SIZE = 4096;
+const CHUNKS = 32;
+const RECORD_SIZE = 4 + 32;
+
+const PT_LOAD = 1;
+const PF_X = 1;
+
+// Executable PT_LOAD file ranges of an ELF image, in program header order
+function executableSegments(image) {
+  if (image.length < 52 || image.readUInt32BE(0) !== 0x7f454c46) {
+    throw new Error('Not an ELF file');
+  }
+  if (image[5] !== 1) {
+    throw new Error('Only little-endian ELF images are supported');
+  }
+
+  const is64 = image[4] === 2;
+  const phoff = is64 ? Number(image.readBigUInt64LE(32)) : image.readUInt32LE(28);
+  const phentsize = image.readUInt16LE(is64 ? 54 : 42);
+  const phnum = image.readUInt16LE(is64 ? 56 : 44);
+
+  const segments = [];
+  for (let i = 0; i < phnum; i++) {
+    const ph = phoff + i * phentsize;
+    const type = image.readUInt32LE(ph);
+    const flags = image.readUInt32LE(is64 ? ph + 4 : ph + 24);
+    const offset = is64 ? Number(image.readBigUInt64LE(ph + 8)) : image.readUInt32LE(ph + 4);
+    const filesz = is64 ? Number(image.readBigUInt64LE(ph + 32)) : image.readUInt32LE(ph + 16);
+    if (type !== PT_LOAD || !(flags & PF_X) || filesz === 0) continue;
+    if (offset + filesz > image.length) {
+      throw new Error('Executable segment extends past the end of the file');
+    }
+    segments.push(image.subarray(offset, offset + filesz));
+  }
+  return segments;
+}
+
+// Cut targets into the chunk views the client numbers 0..N-1
+function chunkTargets(targets) {
+  const chunks = [];
+  for (const target of targets) {
+    for (let offset = 0; offset < target.length; offset += CHUNK_SIZE) {
+      chunks.push(target.subarray(offset, Math.min(offset + CHUNK_SIZE, target.length)));
+    }
+  }
+  return chunks;
+}
+
+function hmac(key, data) {
+  return crypto.createHmac('sha256', key).update(data).digest();
+}
+
+class AttestationValidator {
+  /**
+   * @param {Object<string, Buffer[]>} targetsByAbi reference targets per ABI,
+   *        in the order the client hashes them: library code segments first,
+   *        then attested regions
+   * @param {Object} options challengeTtlMs, maxPending, deadlineMicros,
+   *        rttAllowanceMs (time on top of the deadline for the challenge and
+   *        the response to cross the network)
+   */
+  constructor(targetsByAbi, options = {}) {
+    this.chunksByAbi = new Map();
+    for (const [abi, targets] of Object.entries(targetsByAbi)) {
+      const chunks = chunkTargets(targets);
+      if (chunks.length > 0) this.chunksByAbi.set(abi, chunks);
+    }
+    this.challengeTtlMs = options.challengeTtlMs || 10000;
+    this.maxPending = options.maxPending || 100000;
+    this.deadlineMicros = options.deadlineMicros || 8000;
+    this.rttAllowanceMs = options.rttAllowanceMs || 1000;
+
+    // challengeId -> { nonce, abi, issuedMs, expires }; insertion order is
+    // expiry order. Challenges past their answer time are only kept until
+    // the TTL so they can be reported as late rather than unknown.
+    this.pending = new Map();
+  }
+
+  abis() {
+    return [...this.chunksByAbi.keys()];
+  }
+
+  /**
+   * New single-use challenge for a client running the given ABI
+   * @returns {{challengeId: string, nonce: string, deadlineMicros: number} | null}
+   */
+  issue(abi) {
+    if (!this.chunksByAbi.has(abi)) return null;
+
+    const now = Date.now();
+    this.expire(now);
+    if (this.pending.size >= this.maxPending) {
+      // Oldest challenges are the least likely to still be answered
+      this.pending.delete(this.pending.keys().next().value);
+    }
+
+    const challengeId = crypto.randomBytes(16).toString('hex');
+    const nonce = crypto.randomBytes(NONCE_SIZE);
+    this.pending.set(challengeId, {
+      nonce,
+      abi,
+      issuedMs: performance.now(), // Monotonic, unlike Date.now()
+      expires: now + this.challengeTtlMs
+    });
+    return {
+      challengeId,
+      nonce: nonce.toString('base64'),
+      deadlineMicros: this.deadlineMicros
+    };
+  }
+
+  /**
+   * Check and consume a challenge. Unknown, expired and reused challenges
+   * fail, as do a missing response (the client ran out of time) and one
+   * arriving after the deadline plus the round-trip allowance.
+   * @returns {{valid: boolean, reason: string}}
+   */
+  verify(challengeId, responseBase64) {
+    const challenge = this.pending.get(challengeId);
+    if (!challenge) {
+      return { valid: false, reason: 'unknown_challenge' };
+    }
+    this.pending.delete(challengeId);
+    if (challenge.expires < Date.now()) {
+      return { valid: false, reason: 'expired' };
+    }
+    if (performance.now() - challenge.issuedMs > this.deadlineMicros / 1000 + this.rttAllowanceMs) {
+      return { valid: false, reason: 'late' };
+    }
+    if (typeof responseBase64 !== 'string') {
+      return { valid: false, reason: 'no_response' };
+    }
+
+    const response = Buffer.from(responseBase64, 'base64');
+    const expected = this.expectedResponse(challenge.abi, challenge.nonce);
+    if (response.length !== expected.length || !crypto.timingSafeEqual(response, expected)) {
+      return { valid: false, reason: 'mismatch' };
+    }
+    return { valid: true, reason: 'ok' };
+  }
+
+  expectedResponse(abi, nonce) {
+    const chunks = this.chunksByAbi.get(abi);
+    const counter = Buffer.alloc(4);
+    const transcript = Buffer.allocUnsafe(CHUNKS * RECORD_SIZE);
+
+    for (let block = 0; block < CHUNKS / 8; block++) {
+      counter.writeUInt32BE(block, 0);
+      const seed = hmac(nonce, counter);
+      for (let word = 0; word < 8; word++) {
+        const i = block * 8 + word;
+        const pick = seed.readUInt32BE(word * 4) % chunks.length;
+        const record = i * RECORD_SIZE;
+        transcript.writeUInt32BE(pick, record);
+        hmac(nonce, chunks[pick]).copy(transcript, record + 4);
+      }
+    }
+    return hmac(nonce, transcript);
+  }
+
+  expire(now) {
+    for (const [challengeId, challenge] of this.pending) {
+      if (challenge.expires >= now) break;
+      this.pending.delete(challengeId);
+    }
+  }
+}
+
+/**
+ * Build a validator from the attestation config section. Each ABI's library
+ * contributes its executable segments; assets are shared by all ABIs and
+ * follow the library in the listed order.
+ */
+function createValidator(attestationConfig) {
+  const assets = attestationConfig.assets.map(file => fs.readFileSync(file));
+  const targetsByAbi = {};
+  for (const [abi, library] of Object.entries(attestationConfig.libraries)) {
+    targetsByAbi[abi] = executableSegments(fs.readFileSync(library)).concat(assets);
+  }
+  return new AttestationValidator(targetsByAbi, attestationConfig);
+}
+
+module.exports = {
+  AttestationValidator,
+  createValidator,
+  executableSegments
+};
@@ -84,6 +84,38 @@ const deployConfig = {
     banDuration: parseInt(process.env.BAN_DURATION) || 24 * 60 * 60 * 1000, // 24 hours in milliseconds
   },
   
+  // Attestation challenge settings
+  attestation: {
+    enabled: process.env.ATTESTATION_ENABLED === 'true',
+    
+    // Native library build per ABI, as "abi=/path/lib.so,abi=/path/lib.so"
+    libraries: Object.fromEntries((process.env.ATTESTATION_LIBRARIES || '')
+      .split(',').filter(Boolean).map(entry => entry.split('='))),
+    
+    // Attested asset files, in the order the client registers their regions
+    assets: (process.env.ATTESTATION_ASSETS || '').split(',').filter(Boolean),
+    
+    challengeTtlMs: parseInt(process.env.ATTESTATION_CHALLENGE_TTL_MS) || 10000, // How long unanswered challenges are kept
+    deadlineMicros: parseInt(process.env.ATTESTATION_DEADLINE_MICROS) || 8000, // Half a 60 Hz frame
+    // Network time allowed on top of the deadline between issuing a challenge
+    // and receiving its response; answers arriving later fail as 'late'
+    rttAllowanceMs: parseInt(process.env.ATTESTATION_RTT_ALLOWANCE_MS) || 1000,
+    maxPending: parseInt(process.env.ATTESTATION_MAX_PENDING) || 100000
+  },
+  
+  // Protected value journal replay
+  journal: {
+    enabled: process.env.VALUE_JOURNAL_ENABLED === 'false' ? false : true,
+    maxChunks: parseInt(process.env.VALUE_JOURNAL_MAX_CHUNKS) || 16, // Matches the client's unsent chunk limit
+    maxRecords: parseInt(process.env.VALUE_JOURNAL_MAX_RECORDS) || 25000, // journal.js caps it at 32768
+    
+    // Growth limit per minute for named values
+    rateLimits: {
+      coins: parseInt(process.env.MAX_COINS_PER_MINUTE) || 1000,
+      xp: parseInt(process.env.MAX_XP_PER_MINUTE) || 500
+    }
+  },
+  
   // Logging configuration
   logs: {
     // Log rotation
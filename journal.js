@@ -0,0 +1,272 @@
+
+/**
+ * STFU GameGuardian value journal replay
+ *
+ * Checks the change journal of protected values uploaded by the client. The
+ * wire format is documented in src/lib/memoryGuard/ValueJournal.h: a 32-byte
+ * header, then 32-byte records holding a value's old and new bits, a
+ * CLOCK_MONOTONIC_COARSE timestamp, the handle, a caller tag, the value
+ * type and the operation.
+ *
+ * Two things are checked:
+ *  - chains: every change must start from the value the previous change of
+ *    the same handle left. Anything else is a write that bypassed the
+ *    protected value API, i.e. a memory edit.
+ *  - rates: named values may not grow faster than the configured per-minute
+ *    limit within any one-minute window.
+ * After a gap (dropped records, discarded uploads, a new native context)
+ * chains of that upload restart wherever a link is missing; rates are still
+ * checked.
+ */
+
+const HEADER_SIZE = 32;
+const RECORD_SIZE = 32;
+const MAGIC = 0x314a5653; // "SVJ1"
+
+const TYPE_INT = 1;
+const TYPE_LONG = 2;
+const TYPE_FLOAT = 3;
+const TYPE_DOUBLE = 4;
+const TYPE_BOOLEAN = 5;
+
+const OPS = ['', 'set', 'add', 'clamp_add', 'try_add', 'compare_and_set'];
+
+const MINUTE_NS = 60000000000;
+
+// Hard limits on the work one upload can cause, whatever the configuration:
+// a 1 MB body holds about 24k records
+const MAX_RECORDS_PER_UPLOAD = 32768;
+// Changes of one value within one reordering window (two clock ticks)
+const MAX_WINDOW_RECORDS = 256;
+
+/**
+ * Parse one drained chunk; throws on malformed input
+ * @returns {{nowNs: bigint, dropped: number, resolutionNs: number, records: Object[]}}
+ */
+function parseChunk(chunk) {
+  if (chunk.length < HEADER_SIZE || chunk.readUInt32LE(0) !== MAGIC) {
+    throw new Error('Not a value journal');
+  }
+  const count = chunk.readUInt32LE(4);
+  if (HEADER_SIZE + count * RECORD_SIZE > chunk.length) {
+    throw new Error('Value journal is truncated');
+  }
+
+  const records = new Array(count);
+  for (let i = 0; i < count; i++) {
+    const offset = HEADER_SIZE + i * RECORD_SIZE;
+    records[i] = {
+      timeNs: chunk.readBigUInt64LE(offset),
+      before: chunk.readBigUInt64LE(offset + 8),
+      after: chunk.readBigUInt64LE(offset + 16),
+      handle: chunk.readUInt32LE(offset + 24),
+      tag: chunk.readUInt16LE(offset + 28),
+      type: chunk[offset + 30],
+      op: OPS[chunk[offset + 31]] || 'unknown'
+    };
+  }
+  return {
+    nowNs: chunk.readBigUInt64LE(8),
+    dropped: chunk.readUInt32LE(16),
+    resolutionNs: chunk.readUInt32LE(20),
+    records
+  };
+}
+
+// Value of a record's bits; longs beyond 2^53 lose precision
+function decodeValue(type, bits) {
+  const buffer = Buffer.alloc(8);
+  buffer.writeBigUInt64LE(bits);
+  switch (type) {
+    case TYPE_INT: return buffer.readInt32LE(0);
+    case TYPE_LONG: return Number(buffer.readBigInt64LE(0));
+    case TYPE_FLOAT: return buffer.readFloatLE(0);
+    case TYPE_DOUBLE: return buffer.readDoubleLE(0);
+    case TYPE_BOOLEAN: return buffer[0] !== 0;
+    default: return null;
+  }
+}
+
+// Records of one handle that fall within a clock tick or two of each other,
+// as they are consumed in order. Changes are indexed by the value they start
+// from, and the values they leave are counted, so each chain step is a
+// lookup instead of a scan of the window.
+class ChainWindow {
+  constructor(records, windowNs) {
+    this.records = records;
+    this.windowNs = windowNs;
+    this.taken = new Uint8Array(records.length);
+    this.first = 0; // Oldest record not yet taken
+    this.end = 0;   // Records before this are in the window
+    this.byBefore = new Map(); // before -> {indices, head}
+    this.leaving = new Map();  // after -> untaken records in the window
+    records.forEach((record, i) => {
+      let entry = this.byBefore.get(record.before);
+      if (!entry) this.byBefore.set(record.before, entry = { indices: [], head: 0 });
+      entry.indices.push(i);
+    });
+  }
+
+  // Slide the window to start at the oldest untaken record
+  advance() {
+    while (this.taken[this.first]) this.first++;
+    const horizon = this.records[this.first].timeNs + this.windowNs;
+    for (; this.end < this.records.length && this.records[this.end].timeNs <= horizon; this.end++) {
+      const after = this.records[this.end].after;
+      this.leaving.set(after, (this.leaving.get(after) || 0) + 1);
+    }
+  }
+
+  // Oldest untaken record in the window that starts from `value`, or -1
+  find(value) {
+    const entry = this.byBefore.get(value);
+    if (!entry) return -1;
+    while (entry.head < entry.indices.length && this.taken[entry.indices[entry.head]]) entry.head++;
+    const i = entry.head < entry.indices.length ? entry.indices[entry.head] : -1;
+    return i >= 0 && i < this.end ? i : -1;
+  }
+
+  // First change of a new chain: one that no other change in the window
+  // leads into
+  start() {
+    for (let i = this.first; i < this.end; i++) {
+      if (this.taken[i]) continue;
+      const record = this.records[i];
+      const self = record.after === record.before ? 1 : 0;
+      if ((this.leaving.get(record.before) || 0) - self === 0) return i;
+    }
+    return this.first;
+  }
+
+  take(i) {
+    this.taken[i] = 1;
+    const after = this.records[i].after;
+    this.leaving.set(after, this.leaving.get(after) - 1);
+  }
+}
+
+// Order one handle's time-sorted records by following the chain from
+// `current`. Records within a clock tick or two of each other may come from
+// different threads in any order, so the next link is searched for among
+// them. After lost records (`lenient`) a missing link starts a new chain
+// instead of failing.
+function chainRecords(records, current, windowNs, lenient) {
+  const ordered = [];
+  const window = new ChainWindow(records, windowNs);
+  while (ordered.length < records.length) {
+    window.advance();
+
+    let next = current !== null ? window.find(current) : -1;
+    if (next < 0 && current !== null && !lenient) {
+      return { ordered, broken: records[window.first] };
+    }
+    if (next < 0) {
+      next = window.start();
+    }
+
+    window.take(next);
+    ordered.push(records[next]);
+    current = records[next].after;
+  }
+  return { ordered, broken: null };
+}
+
+// True if more than MAX_WINDOW_RECORDS of a handle's time-sorted records fall
+// within one reordering window
+function windowOverflows(records, windowNs) {
+  for (let i = 0; i + MAX_WINDOW_RECORDS < records.length; i++) {
+    if (records[i + MAX_WINDOW_RECORDS].timeNs - records[i].timeNs <= windowNs) return true;
+  }
+  return false;
+}
+
+// Largest growth of a value within any one-minute window
+function maxGrowthPerMinute(ordered) {
+  let best = 0;
+  let windowGrowth = 0;
+  let start = 0;
+  const growth = ordered.map(record =>
+    Math.max(0, decodeValue(record.type, record.after) - decodeValue(record.type, record.before)));
+  for (let end = 0; end < ordered.length; end++) {
+    windowGrowth += growth[end];
+    while (ordered[end].timeNs - ordered[start].timeNs > BigInt(MINUTE_NS)) {
+      windowGrowth -= growth[start++];
+    }
+    best = Math.max(best, windowGrowth);
+  }
+  return best;
+}
+
+/**
+ * Replay uploaded chunks against the player's saved journal state
+ * @param {Object|null} state from a previous replay of this session: { values: {handle: bits} }
+ * @param {Buffer[]} chunks drained chunks, oldest first
+ * @param {Object<string, string>} names handle -> value name
+ * @param {Object} options gap (client lost records), rateLimits {name: max per minute}, maxRecords
+ * @returns {{valid: boolean, reason: string, state: Object, values: Object}}
+ */
+function replayJournal(state, chunks, names, options = {}) {
+  const parsed = chunks.map(parseChunk);
+  const total = parsed.reduce((sum, chunk) => sum + chunk.records.length, 0);
+  const maxRecords = Math.min(options.maxRecords || MAX_RECORDS_PER_UPLOAD, MAX_RECORDS_PER_UPLOAD);
+  if (total > maxRecords) {
+    return { valid: false, reason: 'too_many_records', state, values: {} };
+  }
+
+  const gap = options.gap || parsed.some(chunk => chunk.dropped > 0);
+  const saved = gap || !state ? {} : state.values;
+  // Timestamps are read just after each change, so allow two clock ticks of disorder
+  const windowNs = 2n * BigInt(parsed.reduce((max, chunk) => Math.max(max, chunk.resolutionNs), 0));
+
+  const byHandle = new Map();
+  for (const chunk of parsed) {
+    for (const record of chunk.records) {
+      if (!byHandle.has(record.handle)) byHandle.set(record.handle, []);
+      byHandle.get(record.handle).push(record);
+    }
+  }
+
+  const nextState = { values: { ...saved } };
+  const values = {};
+  for (const [handle, records] of byHandle) {
+    records.sort((a, b) => (a.timeNs < b.timeNs ? -1 : a.timeNs > b.timeNs ? 1 : 0));
+    if (windowOverflows(records, windowNs)) {
+      return { valid: false, reason: 'too_many_records', state, values: {} };
+    }
+    const name = names[handle] || `#${handle}`;
+    const current = saved[handle] !== undefined ? BigInt(saved[handle]) : null;
+
+    const { ordered, broken } = chainRecords(records, current, windowNs, gap);
+    if (broken) {
+      return {
+        valid: false,
+        reason: `${name} changed outside the protected value API ` +
+          `(${broken.op} from ${decodeValue(broken.type, broken.before)})`,
+        state,
+        values: {}
+      };
+    }
+
+    const limit = options.rateLimits && options.rateLimits[names[handle]];
+    if (limit !== undefined) {
+      const growth = maxGrowthPerMinute(ordered);
+      if (growth > limit) {
+        return { valid: false, reason: `${name} increased too fast (${growth} in one minute)`, state, values: {} };
+      }
+    }
+
+    const last = ordered[ordered.length - 1];
+    nextState.values[handle] = last.after.toString();
+    if (names[handle]) {
+      values[names[handle]] = decodeValue(last.type, last.after);
+    }
+  }
+
+  return { valid: true, reason: 'ok', state: nextState, values };
+}
+
+module.exports = {
+  decodeValue,
+  parseChunk,
+  replayJournal
+};
@@ -9,6 +9,8 @@ const express = require('express');
 const path = require('path');
 const fs = require('fs');
 const config = require('./deploy-config');
+const { createValidator } = require('./attestation');
+const { replayJournal } = require('./journal');
 const https = require('https');
 const helmet = require('helmet');
 const rateLimit = require('express-rate-limit');
@@ -49,6 +51,17 @@ const logger = createLogger({
   ]
 });
 
+// Load attestation reference images
+let attestationValidator = null;
+if (config.attestation.enabled) {
+  try {
+    attestationValidator = createValidator(config.attestation);
+    logger.info(`Attestation enabled for ABIs: ${attestationValidator.abis().join(', ')}`);
+  } catch (error) {
+    logger.error('Failed to load attestation reference images', error);
+  }
+}
+
 // Initialize MongoDB with proper connection handling and retries
 let db;
 let mongoClient;
@@ -434,32 +447,8 @@ app.post('/api/sync-game-values', validateApiKey, checkDatabaseConnection, async
       const verificationResult = await verifyGameValues(player, gameValues, clientTimestamp, checksum);
       
       if (!verificationResult.isValid) {
-        // Increment tampering counter
-        await db.collection('players').updateOne(
-          { playerId },
-          { 
-            $inc: { tamperingAttempts: 1 },
-            $push: { 
-              tampering: { 
-                timestamp: serverTimestamp, 
-                invalidValues: true,
-                reason: verificationResult.reason,
-                sessionId
-              } 
-            }
-          }
-        );
-        
-        // Check if player should be banned
-        const updatedPlayer = await db.collection('players').findOne({ playerId });
-        if (updatedPlayer.tamperingAttempts >= config.protection.maxTamperingAttempts) {
-          // Ban the player
-          await db.collection('players').updateOne(
-            { playerId },
-            { $set: { isBanned: true, banTimestamp: serverTimestamp } }
-          );
-          
-          logger.warn(`Player banned due to tampering: ${playerId}, reason: ${verificationResult.reason}`);
+        const banned = await recordInvalidValues(playerId, sessionId, verificationResult.reason, serverTimestamp);
+        if (banned) {
           return res.status(403).json({
             message: config.serverResponses.terminalMessage,
             action: 'ban',
@@ -518,6 +507,38 @@ app.post('/api/sync-game-values', validateApiKey, checkDatabaseConnection, async
   }
 });
 
+// Count a tampering attempt for rejected game values; bans the player and
+// returns true once the limit is reached
+async function recordInvalidValues(playerId, sessionId, reason, serverTimestamp) {
+  await db.collection('players').updateOne(
+    { playerId },
+    { 
+      $inc: { tamperingAttempts: 1 },
+      $push: { 
+        tampering: { 
+          timestamp: serverTimestamp, 
+          invalidValues: true,
+          reason,
+          sessionId
+        } 
+      }
+    }
+  );
+  
+  // Check if player should be banned
+  const updatedPlayer = await db.collection('players').findOne({ playerId });
+  if (updatedPlayer.tamperingAttempts >= config.protection.maxTamperingAttempts) {
+    await db.collection('players').updateOne(
+      { playerId },
+      { $set: { isBanned: true, banTimestamp: serverTimestamp } }
+    );
+    
+    logger.warn(`Player banned due to tampering: ${playerId}, reason: ${reason}`);
+    return true;
+  }
+  return false;
+}
+
 // Helper function to verify game values
 async function verifyGameValues(player, newValues, clientTimestamp, clientChecksum) {
   // If player has no previous data, we'll trust this first sync
@@ -601,6 +622,136 @@ async function verifyGameValues(player, newValues, clientTimestamp, clientChecks
   return { isValid: true };
 }
 
+// Replay a protected value journal. Replaces full game value snapshots:
+// the server keeps each value's last known bits per session and checks that
+// every recorded change continues from them at an allowed rate.
+app.post('/api/value-journal', validateApiKey, checkDatabaseConnection, async (req, res) => {
+  try {
+    const { playerId, sessionId, journal, names, gap } = req.body || {};
+    
+    if (!playerId || typeof playerId !== 'string') {
+      return res.status(400).json({ error: 'Invalid player ID' });
+    }
+    
+    if (!config.journal.enabled) {
+      return res.status(503).json({ error: 'Value journal not available' });
+    }
+    
+    if (!Array.isArray(journal) || journal.length === 0 || journal.length > config.journal.maxChunks ||
+        !journal.every(chunk => typeof chunk === 'string')) {
+      return res.status(400).json({ error: 'Invalid journal' });
+    }
+    
+    try {
+      const player = await db.collection('players').findOne({ playerId });
+      
+      if (!player) {
+        return res.status(404).json({ error: 'Player not found' });
+      }
+      
+      if (player.isBanned) {
+        return res.status(403).json({ error: 'Account suspended' });
+      }
+      
+      // Chains continue only within the session that started them
+      const saved = player.journal && player.journal.sessionId === sessionId ? player.journal : null;
+      
+      let result;
+      try {
+        result = replayJournal(saved, journal.map(chunk => Buffer.from(chunk, 'base64')),
+          names && typeof names === 'object' ? names : {}, {
+            gap: gap === true,
+            rateLimits: config.journal.rateLimits,
+            maxRecords: config.journal.maxRecords
+          });
+      } catch (error) {
+        return res.status(400).json({ error: 'Malformed journal' });
+      }
+      
+      const serverTimestamp = new Date();
+      if (!result.valid) {
+        const banned = await recordInvalidValues(playerId, sessionId, result.reason, serverTimestamp);
+        logger.warn(`Value journal rejected for player: ${playerId}, reason: ${result.reason}`);
+        return res.status(banned ? 403 : 200).json({
+          message: banned ? config.serverResponses.terminalMessage : config.serverResponses.warningMessage,
+          action: banned ? 'ban' : undefined,
+          status: 'invalid',
+          reason: result.reason
+        });
+      }
+      
+      await db.collection('players').updateOne(
+        { playerId },
+        { 
+          $set: {
+            journal: { sessionId, values: result.state.values },
+            gameData: { ...player.gameData, ...result.values, _lastUpdated: serverTimestamp },
+            lastSync: serverTimestamp
+          }
+        }
+      );
+      
+      return res.status(200).json({ status: 'valid', serverTimestamp: serverTimestamp.toISOString() });
+      
+    } catch (error) {
+      logger.error('Database error replaying value journal:', error);
+      return res.status(500).json({ error: 'Failed to replay value journal' });
+    }
+  } catch (error) {
+    logger.error('Error in value-journal endpoint:', error);
+    return res.status(500).json({ error: 'Internal server error' });
+  }
+});
+
+// Attestation availability check middleware
+const checkAttestationEnabled = (req, res, next) => {
+  if (!attestationValidator) {
+    return res.status(503).json({ error: 'Attestation not available' });
+  }
+  next();
+};
+
+// Issue a single-use attestation nonce
+app.post('/api/attestation/challenge', validateApiKey, checkAttestationEnabled, (req, res) => {
+  const abi = req.body && typeof req.body.abi === 'string' ? req.body.abi : null;
+  const challenge = abi ? attestationValidator.issue(abi) : null;
+  if (!challenge) {
+    return res.status(400).json({ error: 'Unsupported ABI' });
+  }
+  return res.status(200).json(challenge);
+});
+
+// Check an attestation response; each challenge can be answered once
+app.post('/api/attestation/response', validateApiKey, checkAttestationEnabled, (req, res) => {
+  const { challengeId, response, playerId } = req.body || {};
+  if (typeof challengeId !== 'string') {
+    return res.status(400).json({ error: 'Missing challenge ID' });
+  }
+  
+  const result = attestationValidator.verify(challengeId, response);
+  if (result.valid) {
+    return res.status(200).json({ status: 'valid' });
+  }
+  
+  logger.warn('Attestation failed', {
+    reason: result.reason,
+    playerId: typeof playerId === 'string' ? playerId.substring(0, 100) : null
+  });
+  
+  if (db) {
+    db.collection('tampering_logs').insertOne({
+      id: uuidv4(),
+      serverTimestamp: new Date().toISOString(),
+      severity: 'high',
+      type: 'attestation_failed',
+      playerId: typeof playerId === 'string' ? playerId.substring(0, 100) : null,
+      details: { reason: result.reason }
+    }).catch(err => logger.error('Error saving attestation failure to database', err));
+  }
+  
+  return res.status(200).json({ status: 'invalid', reason: result.reason });
+});
+
 // Management API route to retrieve recent logs
 app.get('/api/management/logs', validateApiKey, checkDatabaseConnection, async (req, res) => {
   try {
@@ -0,0 +1,137 @@
+#include "Attestation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <link.h>
+#include <time.h>
+
+#include "ParallelFor.h"
+#include "Sha256.h"
+
+// Fewer chunks than this per worker is not worth a thread
+constexpr size_t kMinChunksPerWorker = 8;
+
+// Chunks MACed between deadline checks
+constexpr size_t kChunksPerDeadlineCheck = 4;
+
+static int64_t monotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+static inline void storeBigEndian(uint32_t value, uint8_t* out) {
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+}
+
+static inline uint32_t loadBigEndian(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+struct CodeSearch {
+    uintptr_t probe;
+    std::vector<AttestTarget>* targets;
+    size_t added;
+};
+
+static int collectCodeSegments(dl_phdr_info* info, size_t, void* arg) {
+    CodeSearch* search = static_cast<CodeSearch*>(arg);
+
+    bool ours = false;
+    for (int i = 0; i < info->dlpi_phnum && !ours; i++) {
+        const ElfW(Phdr)& ph = info->dlpi_phdr[i];
+        uintptr_t start = info->dlpi_addr + ph.p_vaddr;
+        ours = ph.p_type == PT_LOAD && search->probe >= start && search->probe < start + ph.p_memsz;
+    }
+    if (!ours) return 0;
+
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr)& ph = info->dlpi_phdr[i];
+        if (ph.p_type != PT_LOAD || !(ph.p_flags & PF_X) || ph.p_filesz == 0) continue;
+        search->targets->push_back({reinterpret_cast<const uint8_t*>(info->dlpi_addr + ph.p_vaddr),
+                                    static_cast<size_t>(ph.p_filesz)});
+        search->added++;
+    }
+    return 1;
+}
+
+size_t attestCodeTargets(std::vector<AttestTarget>& targets) {
+    CodeSearch search = {reinterpret_cast<uintptr_t>(&attestCodeTargets), &targets, 0};
+    dl_iterate_phdr(collectCodeSegments, &search);
+    return search.added;
+}
+
+// Map global chunk numbers to bytes
+static void locateChunk(const std::vector<AttestTarget>& targets, const std::vector<size_t>& firstChunk,
+                        uint32_t chunk, const uint8_t** data, size_t* size) {
+    size_t t = std::upper_bound(firstChunk.begin(), firstChunk.end(), chunk) - firstChunk.begin() - 1;
+    size_t offset = (chunk - firstChunk[t]) * kAttestChunkSize;
+    *data = targets[t].data + offset;
+    *size = std::min(kAttestChunkSize, targets[t].size - offset);
+}
+
+AttestResult attestTargets(const std::vector<AttestTarget>& targets,
+                           const uint8_t nonce[kAttestNonceSize], int64_t deadlineNs,
+                           unsigned maxThreads, uint8_t response[kAttestResponseSize]) {
+    std::vector<size_t> firstChunk;
+    size_t totalChunks = 0;
+    for (const AttestTarget& target : targets) {
+        firstChunk.push_back(totalChunks);
+        totalChunks += (target.size + kAttestChunkSize - 1) / kAttestChunkSize;
+    }
+    if (totalChunks == 0 || totalChunks > UINT32_MAX) return ATTEST_NO_TARGETS;
+
+    // Picks: eight 32-bit words from each of HMAC(u32be(0)), HMAC(u32be(1)) ...
+    constexpr size_t kSeedBlocks = kAttestChunks / 8;
+    uint8_t counters[kSeedBlocks][4];
+    const uint8_t* seedInputs[kSeedBlocks];
+    size_t seedSizes[kSeedBlocks];
+    for (size_t j = 0; j < kSeedBlocks; j++) {
+        storeBigEndian(static_cast<uint32_t>(j), counters[j]);
+        seedInputs[j] = counters[j];
+        seedSizes[j] = sizeof(counters[j]);
+    }
+    uint8_t seeds[kSeedBlocks * kSha256DigestSize];
+    hmacSha256Batch(nonce, kAttestNonceSize, seedInputs, seedSizes, kSeedBlocks, seeds);
+
+    uint32_t picks[kAttestChunks];
+    const uint8_t* chunkData[kAttestChunks];
+    size_t chunkSizes[kAttestChunks];
+    for (size_t i = 0; i < kAttestChunks; i++) {
+        picks[i] = loadBigEndian(seeds + 4 * i) % static_cast<uint32_t>(totalChunks);
+        locateChunk(targets, firstChunk, picks[i], &chunkData[i], &chunkSizes[i]);
+    }
+
+    // Each record is u32be(pick) || mac; workers fill disjoint records
+    constexpr size_t kRecordSize = 4 + kSha256DigestSize;
+    uint8_t records[kAttestChunks * kRecordSize];
+    std::atomic<bool> late(false);
+    parallelFor(kAttestChunks, maxThreads, kMinChunksPerWorker, [&](size_t first, size_t count) {
+        uint8_t macs[kAttestChunks * kSha256DigestSize];
+        for (size_t done = 0; done < count; done += kChunksPerDeadlineCheck) {
+            if (late.load(std::memory_order_relaxed) || monotonicNs() > deadlineNs) {
+                late.store(true, std::memory_order_relaxed);
+                return;
+            }
+            size_t n = std::min(kChunksPerDeadlineCheck, count - done);
+            hmacSha256Batch(nonce, kAttestNonceSize, chunkData + first + done, chunkSizes + first + done,
+                            n, macs + done * kSha256DigestSize);
+        }
+        for (size_t i = 0; i < count; i++) {
+            uint8_t* record = records + (first + i) * kRecordSize;
+            storeBigEndian(picks[first + i], record);
+            memcpy(record + 4, macs + i * kSha256DigestSize, kSha256DigestSize);
+        }
+    });
+    if (late.load() || monotonicNs() > deadlineNs) return ATTEST_DEADLINE;
+
+    const uint8_t* transcript = records;
+    size_t transcriptSize = sizeof(records);
+    hmacSha256Batch(nonce, kAttestNonceSize, &transcript, &transcriptSize, 1, response);
+    return ATTEST_OK;
+}
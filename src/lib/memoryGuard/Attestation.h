@@ -0,0 +1,56 @@
+#ifndef STFU_ATTESTATION_H
+#define STFU_ATTESTATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Nonce-driven challenge-response over code and static protected regions.
+//
+// The server sends a fresh 32-byte nonce, and the answer depends on both
+// which bytes are hashed and the key they are hashed under. Precomputed
+// answers are therefore useless, and a patched copy only passes if every
+// chunk the nonce picks is untouched.
+//
+// Targets are, in order: this library's executable segments, followed by
+// the regions registered for attestation. The server holds reference
+// images of the same targets (the library's ELF file and the static
+// assets) in the same order. Protocol, with HMAC = HMAC-SHA256 keyed by
+// the nonce:
+//  - Every target is cut into 4 KiB chunks (the last may be short),
+//    numbered across targets from 0 to N - 1.
+//  - Chunk pick i, for i < 32, is the i % 8'th big-endian 32-bit word of
+//    HMAC(u32be(i / 8)), mod N. Repeats are allowed.
+//  - mac_i = HMAC(bytes of chunk pick i)
+//  - response = HMAC(u32be(pick_0) || mac_0 || ... || u32be(pick_31) || mac_31)
+//
+// The chunk MACs are independent, so they are spread across cores. The
+// work stops at the deadline rather than answering late.
+
+constexpr size_t kAttestNonceSize = 32;
+constexpr size_t kAttestChunkSize = 4096;
+constexpr size_t kAttestChunks = 32;
+constexpr size_t kAttestResponseSize = 32;
+
+struct AttestTarget {
+    const uint8_t* data;
+    size_t size;
+};
+
+enum AttestResult {
+    ATTEST_OK = 0,
+    ATTEST_NO_TARGETS = 1,
+    ATTEST_DEADLINE = 2, // Not finished in time; no response
+};
+
+// Append this library's executable PT_LOAD segments, in program header
+// order. Their file-backed bytes (p_filesz) match the ELF file exactly.
+// Returns how many were added.
+size_t attestCodeTargets(std::vector<AttestTarget>& targets);
+
+// Answer `nonce` over `targets`, giving up at deadlineNs (CLOCK_MONOTONIC)
+AttestResult attestTargets(const std::vector<AttestTarget>& targets,
+                           const uint8_t nonce[kAttestNonceSize], int64_t deadlineNs,
+                           unsigned maxThreads, uint8_t response[kAttestResponseSize]);
+
+#endif // STFU_ATTESTATION_H
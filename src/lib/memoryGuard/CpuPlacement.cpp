@@ -0,0 +1,138 @@
+#include "CpuPlacement.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+
+constexpr int kMaxCpus = 64;
+
+// Read a small sysfs file, NUL terminated; false if it can't be read
+static bool readSysfs(const char* path, char* buf, size_t size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    ssize_t n = read(fd, buf, size - 1);
+    close(fd);
+    if (n <= 0) return false;
+    buf[n] = '\0';
+    return true;
+}
+
+static long readSysfsLong(const char* path) {
+    char buf[32];
+    return readSysfs(path, buf, sizeof(buf)) ? strtol(buf, nullptr, 10) : -1;
+}
+
+bool readCpuTopology(const char* root, CpuTopology& topology) {
+    long capacity[kMaxCpus];
+    int domain[kMaxCpus]; // Lowest CPU of each CPU's frequency domain
+    int cpus = 0;
+    char path[256];
+
+    for (int cpu = 0; cpu < kMaxCpus; cpu++) {
+        snprintf(path, sizeof(path), "%s/cpu%d", root, cpu);
+        if (access(path, F_OK) != 0) break;
+        cpus = cpu + 1;
+
+        snprintf(path, sizeof(path), "%s/cpu%d/cpu_capacity", root, cpu);
+        capacity[cpu] = readSysfsLong(path);
+        if (capacity[cpu] < 0) {
+            snprintf(path, sizeof(path), "%s/cpu%d/cpufreq/cpuinfo_max_freq", root, cpu);
+            capacity[cpu] = readSysfsLong(path);
+        }
+
+        // related_cpus lists the domain in ascending order
+        char list[256];
+        snprintf(path, sizeof(path), "%s/cpu%d/cpufreq/related_cpus", root, cpu);
+        long first = readSysfs(path, list, sizeof(list)) ? strtol(list, nullptr, 10) : cpu;
+        domain[cpu] = first >= 0 && first < kMaxCpus ? static_cast<int>(first) : cpu;
+    }
+
+    // A domain runs at its fastest member's capacity; offline CPUs may
+    // not report one
+    long domainCapacity[kMaxCpus];
+    std::fill(domainCapacity, domainCapacity + kMaxCpus, -1L);
+    for (int cpu = 0; cpu < cpus; cpu++) {
+        domainCapacity[domain[cpu]] = std::max(domainCapacity[domain[cpu]], capacity[cpu]);
+    }
+
+    long lowest = LONG_MAX;
+    for (int cpu = 0; cpu < cpus; cpu++) {
+        long c = domainCapacity[domain[cpu]];
+        if (c >= 0) lowest = std::min(lowest, c);
+    }
+
+    CPU_ZERO(&topology.efficiency);
+    CPU_ZERO(&topology.performance);
+    for (int cpu = 0; cpu < cpus; cpu++) {
+        long c = domainCapacity[domain[cpu]];
+        if (c < 0) continue;
+        CPU_SET(cpu, c == lowest ? &topology.efficiency : &topology.performance);
+    }
+    topology.heterogeneous = CPU_COUNT(&topology.efficiency) > 0 &&
+                             CPU_COUNT(&topology.performance) > 0;
+    return cpus > 0;
+}
+
+const CpuTopology& cpuTopology() {
+    static const CpuTopology topology = [] {
+        CpuTopology t = {};
+        readCpuTopology("/sys/devices/system/cpu", t);
+        return t;
+    }();
+    return topology;
+}
+
+// Unprivileged threads can only lower their nice value as far as
+// 20 - RLIMIT_NICE, so a thread is only deprioritized if it can return
+// to `nice` afterwards. Android raises the limit for apps; many desktop
+// systems leave it at 0.
+static bool canRestoreNice(int nice) {
+    if (geteuid() == 0) return true;
+    rlimit limit;
+    if (getrlimit(RLIMIT_NICE, &limit) != 0) return false;
+    return limit.rlim_cur == RLIM_INFINITY || 20 - static_cast<long>(limit.rlim_cur) <= nice;
+}
+
+ScopedCpuPlacement::ScopedCpuPlacement(CpuPlacement placement, bool enabled) {
+    if (!enabled) return;
+
+    const CpuTopology& topology = cpuTopology();
+    if (topology.heterogeneous && sched_getaffinity(0, sizeof(savedAffinity), &savedAffinity) == 0) {
+        const cpu_set_t& cluster = placement == CPU_PLACEMENT_BACKGROUND
+                ? topology.efficiency : topology.performance;
+
+        // Stay within the cpuset the system gave us; if it excludes the
+        // cluster entirely, stay where we are
+        cpu_set_t target;
+        CPU_AND(&target, &savedAffinity, &cluster);
+        if (CPU_COUNT(&target) > 0 && sched_setaffinity(0, sizeof(target), &target) == 0) {
+            restoreAffinity = true;
+        }
+    }
+
+    if (placement == CPU_PLACEMENT_BACKGROUND) {
+        pid_t tid = gettid();
+        errno = 0;
+        int nice = getpriority(PRIO_PROCESS, tid);
+        if (errno == 0 && nice < kBackgroundNice && canRestoreNice(nice) &&
+            setpriority(PRIO_PROCESS, tid, kBackgroundNice) == 0) {
+            savedNice = nice;
+            restoreNice = true;
+        }
+    }
+}
+
+ScopedCpuPlacement::~ScopedCpuPlacement() {
+    if (restoreNice) {
+        setpriority(PRIO_PROCESS, gettid(), savedNice);
+    }
+    if (restoreAffinity) {
+        sched_setaffinity(0, sizeof(savedAffinity), &savedAffinity);
+    }
+}
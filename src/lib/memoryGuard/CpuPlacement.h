@@ -0,0 +1,59 @@
+#ifndef STFU_CPU_PLACEMENT_H
+#define STFU_CPU_PLACEMENT_H
+
+#include <sched.h>
+
+// CPU placement for verification work on heterogeneous (big.LITTLE) SoCs.
+//
+// Periodic checks are background work: they should run on the efficiency
+// cluster at low priority, out of the way of the render thread on the
+// performance cores. Work with a deadline (attestation, which the server
+// times) goes to the faster clusters instead.
+//
+// Clusters come from sysfs: each CPU's cpu_capacity (cpuinfo_max_freq
+// where the kernel has no capacities), grouped by cpufreq frequency
+// domain. The efficiency cluster is the domain with the lowest capacity;
+// every other domain counts as performance. On homogeneous CPUs affinity
+// is left alone.
+//
+// Background priority is nice 10 rather than SCHED_IDLE: an idle-class
+// thread can be starved indefinitely by a busy game, which would trip the
+// liveness watchdog, and unprivileged threads may not leave SCHED_IDLE
+// again. Placement is applied to the calling thread for a scope and then
+// undone; threads and processes started inside the scope (hash workers,
+// the snapshot child) inherit it.
+
+enum CpuPlacement {
+    CPU_PLACEMENT_BACKGROUND = 0, // Efficiency cores, nice 10
+    CPU_PLACEMENT_DEADLINE = 1,   // Performance cores, priority unchanged
+};
+
+constexpr int kBackgroundNice = 10;
+
+struct CpuTopology {
+    bool heterogeneous; // Efficiency and performance sets are both non-empty
+    cpu_set_t efficiency;
+    cpu_set_t performance;
+};
+
+// Parse the topology under `root` (normally /sys/devices/system/cpu)
+bool readCpuTopology(const char* root, CpuTopology& topology);
+
+// This device's topology, read once
+const CpuTopology& cpuTopology();
+
+// Place the calling thread for the lifetime of the scope; `enabled` false
+// makes it a no-op
+struct ScopedCpuPlacement {
+    explicit ScopedCpuPlacement(CpuPlacement placement, bool enabled = true);
+    ~ScopedCpuPlacement();
+    ScopedCpuPlacement(const ScopedCpuPlacement&) = delete;
+    ScopedCpuPlacement& operator=(const ScopedCpuPlacement&) = delete;
+
+    cpu_set_t savedAffinity;
+    bool restoreAffinity = false;
+    int savedNice = 0;
+    bool restoreNice = false;
+};
+
+#endif // STFU_CPU_PLACEMENT_H
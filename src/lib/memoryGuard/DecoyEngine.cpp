@@ -0,0 +1,192 @@
+#include "DecoyEngine.h"
+
+#include <cstring>
+#include <sys/mman.h>
+
+#include "ShieldLog.h"
+
+// Two 64-bit lanes; lowers to NEON on arm64 and SSE2 on x86
+typedef uint64_t DecoyLanes __attribute__((vector_size(16)));
+
+// xorshift64*; only used with the engine mutex held
+static uint64_t nextRandom(DecoyEngine& engine) {
+    uint64_t x = engine.rngState;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    engine.rngState = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static std::atomic<uint8_t>* handleFlag(DecoyEngine& engine, int64_t handle, bool create) {
+    if (handle <= 0) return nullptr;
+
+    uint64_t index = static_cast<uint64_t>(handle - 1);
+    if (index >= kEntriesPerChunk * kMaxEntryChunks) return nullptr;
+
+    auto& chunk = engine.flagChunks[index / kEntriesPerChunk];
+    std::atomic<uint8_t>* flags = chunk.load(std::memory_order_acquire);
+    if (!flags && create) {
+        flags = new std::atomic<uint8_t>[kEntriesPerChunk]();
+        chunk.store(flags, std::memory_order_release);
+    }
+    return flags ? &flags[index % kEntriesPerChunk] : nullptr;
+}
+
+static DecoyPage* mapPage(DecoyEngine& engine) {
+    size_t count = engine.pageCount.load(std::memory_order_relaxed);
+    if (count >= kMaxDecoyPages) return nullptr;
+
+    void* slots = mmap(nullptr, sizeof(uint64_t) * kDecoySlotsPerPage, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (slots == MAP_FAILED) return nullptr;
+
+    DecoyPage* page = new DecoyPage();
+    page->slots = static_cast<uint64_t*>(slots);
+    page->mask = nextRandom(engine);
+    page->used = 0;
+    for (size_t i = 0; i < kDecoySlotsPerPage; i++) {
+        page->expected[i] = page->mask; // Free slots hold zero
+        page->owner[i] = 0;
+    }
+
+    engine.pages[count].store(page, std::memory_order_release);
+    engine.pageCount.store(count + 1, std::memory_order_release);
+    return page;
+}
+
+// Page for the next copy: a random page with room that this value doesn't
+// use yet, else a new page, else any page with room
+static size_t pickPage(DecoyEngine& engine, const std::vector<uint32_t>& taken) {
+    size_t count = engine.pageCount.load(std::memory_order_relaxed);
+    std::vector<size_t> candidates;
+    std::vector<size_t> withRoom;
+
+    for (size_t p = 0; p < count; p++) {
+        DecoyPage* page = engine.pages[p].load(std::memory_order_relaxed);
+        if (page->used >= kDecoySlotsPerPage) continue;
+        withRoom.push_back(p);
+
+        bool shared = false;
+        for (uint32_t id : taken) {
+            if (id / kDecoySlotsPerPage == p) shared = true;
+        }
+        if (!shared) candidates.push_back(p);
+    }
+
+    if (candidates.empty() && mapPage(engine)) {
+        return count;
+    }
+    const std::vector<size_t>& from = candidates.empty() ? withRoom : candidates;
+    if (from.empty()) return kMaxDecoyPages;
+    return from[nextRandom(engine) % from.size()];
+}
+
+void decoyEngineInit(DecoyEngine& engine, uint64_t seed) {
+    std::lock_guard<std::mutex> lock(engine.mutex);
+    engine.rngState = seed | 1;
+}
+
+void decoyEngineDestroy(DecoyEngine& engine) {
+    std::lock_guard<std::mutex> lock(engine.mutex);
+
+    size_t count = engine.pageCount.load();
+    for (size_t p = 0; p < count; p++) {
+        DecoyPage* page = engine.pages[p].load();
+        munmap(page->slots, sizeof(uint64_t) * kDecoySlotsPerPage);
+        delete page;
+        engine.pages[p].store(nullptr);
+    }
+    for (auto& chunk : engine.flagChunks) {
+        delete[] chunk.load();
+        chunk.store(nullptr);
+    }
+
+    engine.pageCount.store(0);
+    engine.byHandle.clear();
+}
+
+int decoyEngineAdd(DecoyEngine& engine, int64_t handle, uint64_t bits, int copies) {
+    std::lock_guard<std::mutex> lock(engine.mutex);
+
+    std::atomic<uint8_t>* flag = handleFlag(engine, handle, true);
+    if (!flag) return 0;
+
+    std::vector<uint32_t>& ids = engine.byHandle[handle];
+    int planted = 0;
+
+    for (int c = 0; c < copies; c++) {
+        size_t p = pickPage(engine, ids);
+        if (p >= kMaxDecoyPages) break;
+
+        DecoyPage* page = engine.pages[p].load(std::memory_order_relaxed);
+        size_t slot = nextRandom(engine) % kDecoySlotsPerPage;
+        while (page->owner[slot] != 0) {
+            slot = (slot + 1) % kDecoySlotsPerPage;
+        }
+
+        page->owner[slot] = handle;
+        page->slots[slot] = bits;
+        page->expected[slot] = bits ^ page->mask;
+        page->used++;
+        ids.push_back(static_cast<uint32_t>(p * kDecoySlotsPerPage + slot));
+        planted++;
+    }
+
+    if (planted > 0) {
+        flag->store(1, std::memory_order_release);
+    }
+    return planted;
+}
+
+void decoyEngineMirror(DecoyEngine& engine, int64_t handle, uint64_t bits) {
+    std::atomic<uint8_t>* flag = handleFlag(engine, handle, false);
+    if (!flag || !flag->load(std::memory_order_acquire)) return;
+
+    std::lock_guard<std::mutex> lock(engine.mutex);
+    auto it = engine.byHandle.find(handle);
+    if (it == engine.byHandle.end()) return;
+
+    for (uint32_t id : it->second) {
+        DecoyPage* page = engine.pages[id / kDecoySlotsPerPage].load(std::memory_order_relaxed);
+        size_t slot = id % kDecoySlotsPerPage;
+        page->slots[slot] = bits;
+        page->expected[slot] = bits ^ page->mask;
+    }
+}
+
+// Confirm a suspect page under the lock; false if a decoy really changed
+static bool confirmPage(DecoyEngine& engine, DecoyPage* page) {
+    std::lock_guard<std::mutex> lock(engine.mutex);
+
+    for (size_t i = 0; i < kDecoySlotsPerPage; i++) {
+        if (page->slots[i] != (page->expected[i] ^ page->mask)) {
+            LOGW("Decoy %p (value %lld) was edited", static_cast<void*>(&page->slots[i]),
+                 static_cast<long long>(page->owner[i]));
+            return false;
+        }
+    }
+    return true;
+}
+
+bool decoyEngineVerify(DecoyEngine& engine) {
+    size_t count = engine.pageCount.load(std::memory_order_acquire);
+
+    for (size_t p = 0; p < count; p++) {
+        DecoyPage* page = engine.pages[p].load(std::memory_order_acquire);
+        const DecoyLanes mask = {page->mask, page->mask};
+        DecoyLanes diff = {0, 0};
+
+        for (size_t i = 0; i < kDecoySlotsPerPage; i += 2) {
+            DecoyLanes slots, expected;
+            memcpy(&slots, &page->slots[i], sizeof(slots));
+            memcpy(&expected, &page->expected[i], sizeof(expected));
+            diff |= slots ^ expected ^ mask;
+        }
+
+        if ((diff[0] | diff[1]) != 0 && !confirmPage(engine, page)) {
+            return false;
+        }
+    }
+    return true;
+}
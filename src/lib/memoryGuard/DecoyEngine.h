@@ -0,0 +1,59 @@
+#ifndef STFU_DECOY_ENGINE_H
+#define STFU_DECOY_ENGINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "ValueStore.h"
+
+// Honeypot copies of protected values.
+//
+// Protected values are masked, so a search-and-filter scan for a known
+// amount only ever lands on the plaintext decoys kept here. Decoys follow
+// every legitimate set of their value; anything else that changes a decoy
+// is an edit by a memory tool. Decoys are spread over separately mapped
+// pages and checked with one vector sweep; suspected mismatches are
+// confirmed under the engine lock, which mirroring also holds, so a
+// concurrent set is never reported.
+
+constexpr size_t kDecoySlotsPerPage = 512; // One 4 KiB page of 8-byte slots
+constexpr size_t kMaxDecoyPages = 64;
+
+struct DecoyPage {
+    uint64_t* slots;                          // Plaintext decoys, own mapping
+    uint64_t expected[kDecoySlotsPerPage];    // Decoy values XOR mask
+    int64_t owner[kDecoySlotsPerPage];        // Handle mirrored, 0 if free
+    uint64_t mask;
+    size_t used;
+};
+
+struct DecoyEngine {
+    std::atomic<DecoyPage*> pages[kMaxDecoyPages] = {};
+    std::atomic<size_t> pageCount{0};
+    std::atomic<std::atomic<uint8_t>*> flagChunks[kMaxEntryChunks] = {};
+
+    // Guarded by mutex
+    std::mutex mutex;
+    std::unordered_map<int64_t, std::vector<uint32_t>> byHandle;
+    uint64_t rngState = 0;
+};
+
+void decoyEngineInit(DecoyEngine& engine, uint64_t seed);
+void decoyEngineDestroy(DecoyEngine& engine);
+
+// Plant `copies` decoys for a value, each on a different page where possible.
+// Returns the number planted.
+int decoyEngineAdd(DecoyEngine& engine, int64_t handle, uint64_t bits, int copies);
+
+// Keep a value's decoys in step with a legitimate set; free for values
+// without decoys
+void decoyEngineMirror(DecoyEngine& engine, int64_t handle, uint64_t bits);
+
+// Sweep all decoys; false if any was written by someone else
+bool decoyEngineVerify(DecoyEngine& engine);
+
+#endif // STFU_DECOY_ENGINE_H
@@ -2,9 +2,13 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <memory>
+#include <atomic>
+#include <thread>
 #include <android/log.h>
-#include <sys/ptrace.h>
+#include <sys/mman.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 #include <dlfcn.h>
 #include <fcntl.h>
@@ -12,28 +16,46 @@
 #include <mutex>
 #include <random>
 #include <algorithm>
+#include <type_traits>
+#include <dirent.h>
 
-#define TAG "STFUGameGuardian"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
-#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
-
-// Struct to track protected memory regions
-struct MemoryRegion {
-    void* address;
-    size_t size;
-    uint32_t checksum;
-    bool valid;
-};
+#include "Attestation.h"
+#include "CpuPlacement.h"
+#include "DecoyEngine.h"
+#include "GameGuardianShieldApi.h"
+#include "HandleTable.h"
+#include "KeyedTreeHash.h"
+#include "LivenessMonitor.h"
+#include "PackageWatch.h"
+#include "PerfCounters.h"
+#include "ProcReader.h"
+#include "RegionGuard.h"
+#include "RootDetector.h"
+#include "SealedTable.h"
+#include "Sha256.h"
+#include "ShieldContext.h"
+#include "ShieldLog.h"
+#include "SnapshotVerifier.h"
+#include "StallWatchdog.h"
+#include "ValueJournal.h"
+#include "ValueStore.h"
+#include "Vault.h"
 
-// Struct to store protected values
-template <typename T>
-struct ProtectedValue {
-    T value;
-    T originalValue;
-    uint32_t checksum;
-    bool valid;
-};
+// Upper bound on threads used to hash a single large region
+constexpr unsigned kMaxHashThreads = 4;
+
+// Address space reserved for the sealed table (32 bytes per protected 4 KiB)
+constexpr size_t kSealedTableReserve = 64 << 20;
+
+// Memory checks between sealed table relocations
+constexpr int kSealedRelocateInterval = 16;
+
+// Time per value check spent moving protected values to new slots
+constexpr int64_t kDefaultRelocationBudgetNs = 200000;
+
+// Shared /proc reader arena: one page per small file, up to 512 KiB for maps
+constexpr size_t kProcSlots = 128;
+constexpr size_t kProcSlotBytes = 4096;
 
 // Known cheat tool packages
 const std::vector<std::string> CHEAT_PACKAGES = {
@@ -51,55 +73,406 @@ const std::vector<std::string> CHEAT_PACKAGES = {
     "com.finalshare.freecoin",
 };
 
-// Global variables
-static std::vector<MemoryRegion> g_memoryRegions;
-static std::unordered_map<long, void*> g_protectedPtrs;
-static std::mutex g_mutex;
-static bool g_initialized = false;
-static std::mt19937 g_rng;
+// Directories whose entries change when apps are installed or removed
+static const char* const kPackageDirs[] = {
+    "/data/app",
+    "/data/data",
+    "/sdcard/Android/data",
+};
+
+// Process-wide; every context attaches watchdog callbacks through it
+static std::atomic<JavaVM*> g_javaVm(nullptr);
+
+// GameGuardianShield.nativeContext, looked up once
+static std::atomic<jfieldID> g_contextField(nullptr);
+
+// Threads available for hashing one region
+static unsigned hashThreadCount() {
+    unsigned cores = std::thread::hardware_concurrency();
+    return std::max(1u, std::min(cores, kMaxHashThreads));
+}
+
+static jfieldID contextField(JNIEnv* env, jobject thiz) {
+    jfieldID field = g_contextField.load(std::memory_order_acquire);
+    if (!field) {
+        jclass shieldClass = env->GetObjectClass(thiz);
+        field = env->GetFieldID(shieldClass, "nativeContext", "J");
+        env->DeleteLocalRef(shieldClass);
+        if (field) g_contextField.store(field, std::memory_order_release);
+    }
+    return field;
+}
 
-// Calculate memory region checksum
-uint32_t calculateChecksum(void* addr, size_t size) {
-    if (!addr || size == 0) return 0;
+// Handle of the context behind a GameGuardianShield object; 0 once destroyed
+static int64_t contextHandle(JNIEnv* env, jobject thiz) {
+    jfieldID field = contextField(env, thiz);
+    return field ? env->GetLongField(thiz, field) : 0;
+}
+
+// Scoped use of the context behind a GameGuardianShield object; null once
+// nativeDestroy has started, which waits for every scope still open before
+// freeing the context
+struct ContextRef {
+    ContextRef(JNIEnv* env, jobject thiz) : ref(contextHandle(env, thiz), HANDLE_CONTEXT) {}
+    
+    ShieldContext* get() const { return static_cast<ShieldContext*>(ref.object); }
+    operator ShieldContext*() const { return get(); }
+    ShieldContext* operator->() const { return get(); }
+    ShieldContext& operator*() const { return *get(); }
+    
+    HandleRef ref;
+};
+
+// Seed the RNG and create the sealed table with a fresh session key.
+// Called with the context mutex held; regions may be registered before init.
+static bool ensureSessionState(ShieldContext& ctx) {
+    if (ctx.sealedTable.base) return true;
     
-    uint32_t checksum = 0;
-    uint8_t* ptr = static_cast<uint8_t*>(addr);
+    std::random_device rd;
+    std::seed_seq seed{rd(), rd(), rd(), rd(), rd(), rd(), rd(), rd()};
+    ctx.rng.seed(seed);
     
-    for (size_t i = 0; i < size; i++) {
-        checksum = ((checksum << 5) + checksum) + ptr[i];
+    // Per-session key for region MACs
+    TreeHashKey key;
+    for (auto& word : key.words) {
+        word = static_cast<uint32_t>(ctx.rng());
     }
     
-    return checksum;
+    uint64_t valueSeed = (static_cast<uint64_t>(ctx.rng()) << 32) | ctx.rng();
+    valueStoreInit(ctx.valueStore, valueSeed);
+    decoyEngineInit(ctx.decoys, valueSeed ^ (static_cast<uint64_t>(ctx.rng()) << 17));
+    return sealedTableCreate(ctx.sealedTable, kSealedTableReserve, key);
 }
 
-// Check if process is being debugged
-bool isBeingDebugged() {
-    // Try to detect tracers
-    if (ptrace(PTRACE_TRACEME, 0, 1, 0) < 0) {
-        return true; // Already being traced
-    }
-    ptrace(PTRACE_DETACH, 0, 1, 0); // Detach
-    
-    // Check TracerPid in /proc/self/status
-    FILE *f = fopen("/proc/self/status", "r");
-    if (f) {
-        char line[256];
-        while (fgets(line, sizeof(line), f)) {
-            if (strncmp(line, "TracerPid:", 10) == 0) {
-                int pid;
-                if (sscanf(line + 10, "%d", &pid) == 1 && pid != 0) {
-                    fclose(f);
-                    return true; // Being traced
-                }
-                break;
+// Raw bit patterns of protected scalars as kept by the value store
+template <typename T>
+static uint64_t toBits(T value) {
+    uint64_t bits = 0;
+    memcpy(&bits, &value, sizeof(T));
+    return bits;
+}
+
+template <typename T>
+static T fromBits(uint64_t bits) {
+    T value;
+    memcpy(&value, &bits, sizeof(T));
+    return value;
+}
+
+// Create a protected value, setting up session state on first use
+static jlong protectBits(ShieldContext* ctx, uint64_t bits, bool redundant = false) {
+    if (!ctx) return 0;
+    {
+        std::lock_guard<std::mutex> lock(ctx->mutex);
+        if (!ensureSessionState(*ctx)) return 0;
+    }
+    return valueStoreCreate(ctx->valueStore, bits, redundant);
+}
+
+// Read a protected value; unknown handles read as zero
+static uint64_t getBits(ShieldContext* ctx, jlong handle) {
+    uint64_t bits = 0;
+    if (ctx) valueStoreGet(ctx->valueStore, handle, &bits);
+    return bits;
+}
+
+static constexpr JournalValueType journalTypeOf(jint) { return JOURNAL_INT; }
+static constexpr JournalValueType journalTypeOf(jlong) { return JOURNAL_LONG; }
+static constexpr JournalValueType journalTypeOf(jfloat) { return JOURNAL_FLOAT; }
+static constexpr JournalValueType journalTypeOf(jdouble) { return JOURNAL_DOUBLE; }
+static constexpr JournalValueType journalTypeOf(jboolean) { return JOURNAL_BOOLEAN; }
+
+// Legitimate set: update the value and keep its decoys and journal in step
+template <typename T>
+static void setValue(ShieldContext* ctx, jlong handle, T value) {
+    uint64_t bits = toBits<T>(value);
+    uint64_t before = 0;
+    if (ctx && valueStoreSet(ctx->valueStore, handle, bits, &before)) {
+        decoyEngineMirror(ctx->decoys, handle, bits);
+        if (before != bits) {
+            journalRecord(ctx->journal, handle, before, bits, journalTypeOf(value), JOURNAL_SET);
+        }
+    }
+}
+
+// Atomic read-modify-write of a protected value; decoys and the journal
+// follow any change. Returns false for unknown handles.
+static bool updateBits(ShieldContext* ctx, jlong handle, ValueUpdate update, const void* arg,
+                       JournalValueType type, JournalOp op, uint64_t* before, uint64_t* after) {
+    if (!ctx || !valueStoreUpdate(ctx->valueStore, handle, update, arg, before, after)) {
+        return false;
+    }
+    if (*after != *before) {
+        decoyEngineMirror(ctx->decoys, handle, *after);
+        journalRecord(ctx->journal, handle, *before, *after, type, op);
+    }
+    return true;
+}
+
+// Integers wrap like Java arithmetic
+template <typename T>
+static bool addUpdate(uint64_t bits, const void* arg, uint64_t* next) {
+    T delta = *static_cast<const T*>(arg);
+    if constexpr (std::is_integral<T>::value) {
+        using U = typename std::make_unsigned<T>::type;
+        *next = toBits<T>(static_cast<T>(static_cast<U>(fromBits<T>(bits)) + static_cast<U>(delta)));
+    } else {
+        *next = toBits<T>(fromBits<T>(bits) + delta);
+    }
+    return true;
+}
+
+// Returns the sum stored; unknown handles read as zero
+template <typename T>
+static T addValue(ShieldContext* ctx, jlong handle, T delta) {
+    uint64_t before = 0;
+    uint64_t after = 0;
+    updateBits(ctx, handle, addUpdate<T>, &delta, journalTypeOf(delta), JOURNAL_ADD, &before, &after);
+    return fromBits<T>(after);
+}
+
+// Add for integers with a range: saturates instead of wrapping, then either
+// clamps the sum into [min, max] or refuses the change
+struct BoundedAdd {
+    int64_t delta;
+    int64_t min;
+    int64_t max;
+    bool clamp;
+};
+
+template <typename T>
+static bool boundedAddUpdate(uint64_t bits, const void* arg, uint64_t* next) {
+    const BoundedAdd* add = static_cast<const BoundedAdd*>(arg);
+    int64_t sum;
+    if (__builtin_add_overflow(static_cast<int64_t>(fromBits<T>(bits)), add->delta, &sum)) {
+        sum = add->delta < 0 ? INT64_MIN : INT64_MAX;
+    }
+    if (sum < add->min || sum > add->max) {
+        if (!add->clamp) return false;
+        sum = sum < add->min ? add->min : add->max;
+    }
+    *next = toBits<T>(static_cast<T>(sum));
+    return true;
+}
+
+// Returns the value stored; unknown handles read as zero
+template <typename T>
+static T clampAddValue(ShieldContext* ctx, jlong handle, T delta, T min, T max) {
+    BoundedAdd add{delta, min, max, true};
+    uint64_t before = 0;
+    uint64_t after = 0;
+    updateBits(ctx, handle, boundedAddUpdate<T>, &add, journalTypeOf(delta), JOURNAL_CLAMP_ADD,
+               &before, &after);
+    return fromBits<T>(after);
+}
+
+// Applies the add only if the sum stays in [min, max]
+template <typename T>
+static jboolean tryAddValue(ShieldContext* ctx, jlong handle, T delta, T min, T max) {
+    BoundedAdd add{delta, min, max, false};
+    uint64_t before = 0;
+    uint64_t after = 0;
+    if (!updateBits(ctx, handle, boundedAddUpdate<T>, &add, journalTypeOf(delta), JOURNAL_TRY_ADD,
+                    &before, &after)) {
+        return JNI_FALSE;
+    }
+    
+    // The update is pure, so rerunning it on the value it saw gives its verdict
+    uint64_t next;
+    return boundedAddUpdate<T>(before, &add, &next) ? JNI_TRUE : JNI_FALSE;
+}
+
+struct CompareAndSet {
+    uint64_t expected;
+    uint64_t desired;
+};
+
+static bool compareAndSetUpdate(uint64_t bits, const void* arg, uint64_t* next) {
+    const CompareAndSet* cas = static_cast<const CompareAndSet*>(arg);
+    if (bits != cas->expected) return false;
+    *next = cas->desired;
+    return true;
+}
+
+// Compares bit patterns, so for floats -0.0 != 0.0 and a NaN matches itself
+template <typename T>
+static jboolean compareAndSetValue(ShieldContext* ctx, jlong handle, T expected, T desired) {
+    CompareAndSet cas{toBits<T>(expected), toBits<T>(desired)};
+    uint64_t before = 0;
+    uint64_t after = 0;
+    bool known = updateBits(ctx, handle, compareAndSetUpdate, &cas, journalTypeOf(expected),
+                            JOURNAL_COMPARE_AND_SET, &before, &after);
+    return known && before == cas.expected ? JNI_TRUE : JNI_FALSE;
+}
+
+// Region behind a handle from nativeProtectMemoryRegion/nativeProtectBytes,
+// usable while `ref` is held; null if it is stale or not the caller's. Its
+// context outlives `ref`: nativeDestroy retires region handles first.
+static ShieldRegion* regionOf(JNIEnv* env, jobject thiz, const HandleRef& ref) {
+    if (!ref.object || ref.owner != ContextRef(env, thiz).get()) return nullptr;
+    return static_cast<ShieldRegion*>(ref.object);
+}
+
+// Vault behind a handle from nativeCreateVault, as for regionOf
+static Vault* vaultOf(JNIEnv* env, jobject thiz, const HandleRef& ref) {
+    if (!ref.object || ref.owner != ContextRef(env, thiz).get()) return nullptr;
+    return static_cast<Vault*>(ref.object);
+}
+
+// Random page-aligned placement for relocated tables; 0 lets the kernel pick
+static uintptr_t randomMappingHint(ShieldContext& ctx) {
+    if (sizeof(uintptr_t) < 8) return 0;
+    uint64_t page = static_cast<uint64_t>(ctx.rng()) % (1u << 24);
+    return static_cast<uintptr_t>((page + (1u << 20)) << 14);
+}
+
+// The context's reader for the /proc detectors, created on first use.
+// Caller holds ctx.procMutex.
+static ProcReader* procReader(ShieldContext& ctx) {
+    if (!ctx.procReaderReady) {
+        ctx.procReaderReady = procReaderInit(ctx.procReader, kProcSlots, kProcSlotBytes);
+    }
+    return ctx.procReaderReady ? &ctx.procReader : nullptr;
+}
+
+// Parse the integer after `field` (e.g. "TracerPid:") in a /proc status
+// buffer that is not NUL terminated. Returns -1 if the field is missing.
+static long parseStatusField(const char* data, size_t length, const char* field) {
+    size_t fieldLength = strlen(field);
+    const char* end = data + length;
+    for (const char* line = data; line < end;) {
+        const char* next = static_cast<const char*>(memchr(line, '\n', end - line));
+        if (!next) next = end;
+        if (static_cast<size_t>(next - line) > fieldLength && memcmp(line, field, fieldLength) == 0) {
+            const char* p = line + fieldLength;
+            while (p < next && (*p == ' ' || *p == '\t')) p++;
+            long value = 0;
+            bool digits = false;
+            for (; p < next && *p >= '0' && *p <= '9'; p++) {
+                value = value * 10 + (*p - '0');
+                digits = true;
             }
+            return digits ? value : -1;
         }
-        fclose(f);
+        line = next + 1;
     }
+    return -1;
+}
+
+// Check if process is being debugged
+bool isBeingDebugged(ShieldContext& ctx) {
+    // TracerPid in /proc/self/status names any ptrace tracer. There is no
+    // PTRACE_TRACEME probe: a tracee cannot detach itself, so a successful
+    // one would leave our parent tracing us for good.
+    std::lock_guard<std::mutex> lock(ctx.procMutex);
+    ProcReader* reader = procReader(ctx);
+    if (!reader) return false;
     
+    ProcRead read = {"/proc/self/status", 1, nullptr, 0};
+    procReaderBatch(*reader, &read, 1);
+    return read.length > 0 && parseStatusField(read.data, read.length, "TracerPid:") > 0;
+}
+
+// True if a cheat package name appears in `data`
+static bool containsCheatPackage(const char* data, size_t length) {
+    for (const auto& package : CHEAT_PACKAGES) {
+        if (memmem(data, length, package.data(), package.size())) {
+            LOGW("Cheat package found in /proc: %s", package.c_str());
+            return true;
+        }
+    }
     return false;
 }
 
+// Blocklisted package present in the sorted installed list, or visible as
+// an app data directory (older Android versions let apps stat those)
+static const std::string* findCheatPackage(const std::vector<std::string>& installed) {
+    for (const auto& package : CHEAT_PACKAGES) {
+        if (std::binary_search(installed.begin(), installed.end(), package)) {
+            return &package;
+        }
+    }
+    
+    char path[256];
+    for (const auto& package : CHEAT_PACKAGES) {
+        snprintf(path, sizeof(path), "/data/data/%s", package.c_str());
+        if (faccessat(AT_FDCWD, path, F_OK, AT_EACCESS) == 0) return &package;
+        snprintf(path, sizeof(path), "/sdcard/Android/data/%s", package.c_str());
+        if (faccessat(AT_FDCWD, path, F_OK, AT_EACCESS) == 0) return &package;
+    }
+    return nullptr;
+}
+
+// Look for cheat processes by batch-reading every visible /proc/<pid>/cmdline.
+// Android 7+ mounts /proc with hidepid, so this mostly fires on rooted or
+// older devices, which is where these tools run.
+static bool detectCheatProcesses(ShieldContext& ctx) {
+    std::vector<std::string> paths;
+    DIR* dir = opendir("/proc");
+    if (!dir) return false;
+    while (dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] < '1' || entry->d_name[0] > '9') continue;
+        paths.push_back(std::string("/proc/") + entry->d_name + "/cmdline");
+    }
+    closedir(dir);
+
+    std::vector<ProcRead> reads(paths.size());
+    for (size_t i = 0; i < paths.size(); i++) {
+        reads[i] = {paths[i].c_str(), 1, nullptr, 0};
+    }
+
+    std::lock_guard<std::mutex> lock(ctx.procMutex);
+    ProcReader* reader = procReader(ctx);
+    if (!reader) return false;
+
+    for (size_t done = 0; done < reads.size();) {
+        size_t filled = procReaderBatch(*reader, &reads[done], reads.size() - done);
+        if (filled == 0) break;
+        for (size_t i = done; i < done + filled; i++) {
+            // argv[0] is the package name, optionally with a ":process" suffix
+            if (reads[i].length > 0 &&
+                containsCheatPackage(reads[i].data, strnlen(reads[i].data, reads[i].length))) {
+                return true;
+            }
+        }
+        done += filled;
+    }
+    return false;
+}
+
+// Root evidence, gathered once per probe table: root status does not change
+// while the game runs, and the probes cost a few dozen syscalls
+static int rootSignals(ShieldContext& ctx) {
+    int cached = ctx.rootSignals.load(std::memory_order_acquire);
+    if (cached >= 0) return cached;
+    
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    cached = ctx.rootSignals.load(std::memory_order_acquire);
+    if (cached >= 0) return cached; // Another thread probed while we waited
+    
+    uint32_t signals;
+    if (ctx.rootPaths.empty()) {
+        signals = rootProbePaths(kDefaultRootPaths, kDefaultRootPathCount);
+    } else {
+        std::vector<const char*> paths;
+        for (const auto& path : ctx.rootPaths) {
+            paths.push_back(path.c_str());
+        }
+        signals = rootProbePaths(paths.data(), paths.size());
+    }
+    {
+        std::lock_guard<std::mutex> procLock(ctx.procMutex);
+        ProcReader* reader = procReader(ctx);
+        const char* data;
+        ssize_t length = reader ? procReadFile(*reader, "/proc/self/mountinfo", &data) : -1;
+        if (length > 0) signals |= rootScanMountinfo(data, length);
+    }
+    signals |= rootCheckSelinux();
+    
+    ctx.rootSignals.store(static_cast<int>(signals), std::memory_order_release);
+    return static_cast<int>(signals);
+}
+
 // Check for emulator
 bool isEmulator() {
     // Check common emulator properties
@@ -124,17 +497,40 @@ bool isEmulator() {
 }
 
 // Detect cheating tools in memory
-bool detectCheatToolsInMemory() {
-    // This would scan memory for signatures of cheating tools
-    // Simplified version for this implementation
-    return false;
+bool detectCheatToolsInMemory(ShieldContext& ctx) {
+    // Injected cheat libraries and their data files show up in our own maps
+    std::lock_guard<std::mutex> lock(ctx.procMutex);
+    ProcReader* reader = procReader(ctx);
+    if (!reader) return false;
+
+    const char* data;
+    ssize_t length = procReadFile(*reader, "/proc/self/maps", &data);
+    return length > 0 && containsCheatPackage(data, length);
+}
+
+// Kind of mapping behind a region the game registered, from our maps.
+// Called with ctx.mutex held.
+static MappingKind regionMapping(ShieldContext& ctx, const void* addr, size_t size) {
+    std::lock_guard<std::mutex> lock(ctx.procMutex);
+    ProcReader* reader = procReader(ctx);
+    if (!reader) return MAPPING_UNKNOWN;
+
+    const char* data;
+    ssize_t length = procReadFile(*reader, "/proc/self/maps", &data);
+    return length > 0 ? classifyMapping(data, static_cast<size_t>(length), addr, size)
+                      : MAPPING_UNKNOWN;
+}
+
+// Where a detector run adds its counters; null while instrumentation is off
+static DetectorStats* detectorStats(ShieldContext& ctx, Detector detector) {
+    return ctx.perfCounters.load(std::memory_order_relaxed) ? &ctx.detectorStats[detector] : nullptr;
 }
 
 // Obfuscate a value using XOR with a random key
 template <typename T>
-T obfuscate(T value) {
+T obfuscate(std::mt19937& rng, T value) {
     std::uniform_int_distribution<uint32_t> dist;
-    uint32_t key = dist(g_rng);
+    uint32_t key = dist(rng);
     return *reinterpret_cast<T*>(reinterpret_cast<uintptr_t>(&value) ^ key) ^ key;
 }
 
@@ -144,28 +540,118 @@ T deobfuscate(T value, uint32_t key) {
     return *reinterpret_cast<T*>(reinterpret_cast<uintptr_t>(&value) ^ key) ^ key;
 }
 
+static int64_t monotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// Hand a violation found off the Java check thread to the shield's
+// countermeasure path. Runs on the watchdog thread, which is attached only
+// for the call.
+static void reportViolationToJava(ShieldContext& ctx, const char* type) {
+    JNIEnv* env = nullptr;
+    JavaVM* vm = g_javaVm.load();
+    if (!vm || !ctx.shieldRef || vm->AttachCurrentThread(&env, nullptr) != JNI_OK) {
+        return;
+    }
+    
+    jclass shieldClass = env->GetObjectClass(ctx.shieldRef);
+    jmethodID onViolation = env->GetMethodID(shieldClass, "onNativeViolation", "(Ljava/lang/String;)V");
+    if (onViolation) {
+        jstring typeStr = env->NewStringUTF(type);
+        env->CallVoidMethod(ctx.shieldRef, onViolation, typeStr);
+        env->DeleteLocalRef(typeStr);
+    }
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+    }
+    env->DeleteLocalRef(shieldClass);
+    vm->DetachCurrentThread();
+}
+
+// Stall watchdog tick: prove the watchdog is alive and check that the
+// detector threads are too
+static void watchdogTick(void* arg, int64_t nowNs) {
+    ShieldContext& ctx = *static_cast<ShieldContext*>(arg);
+    livenessBeat(ctx.liveness, ctx.watchdogSlot);
+    uint32_t missed = livenessCheck(ctx.liveness, ctx.watchdogChecker, ctx.watchdogSlot, nowNs,
+                                    ctx.stallWatchdog.stallThresholdNs);
+    if (missed) {
+        LOGW("Detector thread missed its deadline (slots 0x%x)", missed);
+        reportViolationToJava(ctx, "detector_suspended");
+    }
+}
+
+// Native write API for game code (see GameGuardianShieldApi.h).
+// Takes no context lock: the verifier only retries torn leaves, and the
+// handle table keeps the region alive until the call returns.
+bool stfuBeginRegionWrite(int64_t handle, size_t offset, size_t size) {
+    HandleRef ref(handle, HANDLE_REGION);
+    ShieldRegion* region = static_cast<ShieldRegion*>(ref.object);
+    if (!region) return false;
+    return beginRegionWrite(region->context->sealedTable, region->region, offset, size);
+}
+
+bool stfuEndRegionWrite(int64_t handle, size_t offset, size_t size) {
+    HandleRef ref(handle, HANDLE_REGION);
+    ShieldRegion* region = static_cast<ShieldRegion*>(ref.object);
+    if (!region) return false;
+    return endRegionWrite(region->context->sealedTable, region->region, offset, size);
+}
+
+bool stfuVaultRead(int64_t handle, size_t offset, void* out, size_t size) {
+    HandleRef ref(handle, HANDLE_VAULT);
+    Vault* vault = static_cast<Vault*>(ref.object);
+    if (!vault || !out) return false;
+    return vaultRead(*vault, offset, out, size);
+}
+
+bool stfuVaultWrite(int64_t handle, size_t offset, const void* data, size_t size) {
+    HandleRef ref(handle, HANDLE_VAULT);
+    Vault* vault = static_cast<Vault*>(ref.object);
+    if (!vault || !data) return false;
+    return vaultWrite(*vault, offset, data, size);
+}
+
 // JNI Functions
 
 extern "C" {
 
+    // New native context for one GameGuardianShield instance; the Java side
+    // keeps its handle in nativeContext until nativeDestroy
+    JNIEXPORT jlong JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeCreateContext(
+            JNIEnv *env, jobject thiz) {
+        ShieldContext* ctx = new ShieldContext(kDefaultRelocationBudgetNs);
+        int64_t handle = handleCreate(HANDLE_CONTEXT, ctx, ctx);
+        if (!handle) delete ctx;
+        return handle;
+    }
+    
     // Initialize protection
     JNIEXPORT jboolean JNICALL
     Java_com_stfugg_STFUGameGuardian_initNativeProtection(
             JNIEnv *env, jobject thiz, jobject context) {
-        std::lock_guard<std::mutex> lock(g_mutex);
+        ContextRef ctx(env, thiz);
+        if (!ctx) return JNI_FALSE;
+        
+        std::lock_guard<std::mutex> lock(ctx->mutex);
         
-        if (g_initialized) {
+        if (ctx->initialized) {
             return JNI_TRUE; // Already initialized
         }
         
         LOGI("Initializing native protection");
         
-        // Initialize random number generator with random seed
-        std::random_device rd;
-        g_rng.seed(rd());
+        // Initialize random number generator, session key and sealed table
+        if (!ensureSessionState(*ctx)) {
+            LOGE("Failed to create sealed table");
+            return JNI_FALSE;
+        }
         
         // Check for debuggers
-        if (isBeingDebugged()) {
+        if (isBeingDebugged(*ctx)) {
             LOGW("Debugger detected");
             return JNI_FALSE;
         }
@@ -176,47 +662,35 @@ extern "C" {
         //     return JNI_FALSE;
         // }
         
-        g_initialized = true;
+        packageWatchStart(ctx->packageWatch, kPackageDirs, sizeof(kPackageDirs) / sizeof(kPackageDirs[0]));
+        
+        ctx->initialized = true;
         return JNI_TRUE;
     }
     
     // Detect cheating tools
     JNIEXPORT jboolean JNICALL
     Java_com_stfugg_STFUGameGuardian_detectCheatTools(JNIEnv *env, jobject thiz) {
-        // Get the package manager
-        jclass contextClass = env->GetObjectClass(thiz);
-        jmethodID getContextMethod = env->GetMethodID(contextClass, "getContext", 
-                                               "()Landroid/content/Context;");
-        jobject context = env->CallObjectMethod(thiz, getContextMethod);
-        
-        jclass contextClass2 = env->GetObjectClass(context);
-        jmethodID getPackageManagerId = env->GetMethodID(contextClass2, "getPackageManager", 
-                                               "()Landroid/content/pm/PackageManager;");
-        jobject packageManager = env->CallObjectMethod(context, getPackageManagerId);
-        
-        // Check for cheat tool packages
-        for (const auto& package : CHEAT_PACKAGES) {
-            jclass packageManagerClass = env->GetObjectClass(packageManager);
-            jmethodID getPackageInfoId = env->GetMethodID(packageManagerClass, "getPackageInfo", 
-                                               "(Ljava/lang/String;I)Landroid/content/pm/PackageInfo;");
-            
-            jstring packageNameStr = env->NewStringUTF(package.c_str());
-            
-            try {
-                env->CallObjectMethod(packageManager, getPackageInfoId, packageNameStr, 0);
-                env->DeleteLocalRef(packageNameStr);
-                LOGW("Cheat tool detected: %s", package.c_str());
-                return JNI_TRUE; // Package exists
-            } catch (...) {
-                // Package doesn't exist, continue checking
-                env->ExceptionClear();
-            }
-            
-            env->DeleteLocalRef(packageNameStr);
+        ContextRef ctx(env, thiz);
+        if (!ctx) return JNI_FALSE;
+        
+        ScopedCpuPlacement placement(CPU_PLACEMENT_BACKGROUND,
+                                     ctx->cpuPlacement.load(std::memory_order_relaxed));
+        ScopedPerfCounters counters(detectorStats(*ctx, DETECTOR_CHEAT_TOOLS));
+        
+        // Installed packages: cached, refreshed by nativeCheckPackages() on change
+        if (ctx->cheatPackageInstalled.load(std::memory_order_relaxed)) {
+            return JNI_TRUE;
+        }
+        
+        // Check for running cheat processes
+        if (detectCheatProcesses(*ctx)) {
+            LOGW("Cheat tool process detected");
+            return JNI_TRUE;
         }
         
         // Check for in-memory signatures
-        if (detectCheatToolsInMemory()) {
+        if (detectCheatToolsInMemory(*ctx)) {
             LOGW("Cheat tool signatures detected in memory");
             return JNI_TRUE;
         }
@@ -224,53 +698,882 @@ extern "C" {
         return JNI_FALSE;
     }
     
-    // Protect memory region
+    // Whether the installed package set may have changed since the last comparison
+    JNIEXPORT jboolean JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativePackagesChanged(
+            JNIEnv *env, jobject thiz) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return JNI_FALSE;
+        
+        std::lock_guard<std::mutex> lock(ctx->mutex);
+        return packageWatchPoll(ctx->packageWatch) ? JNI_TRUE : JNI_FALSE;
+    }
+    
+    // Package broadcast received; safe from any thread
     JNIEXPORT void JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeNotifyPackagesChanged(
+            JNIEnv *env, jobject thiz) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return;
+        
+        packageWatchMarkChanged(ctx->packageWatch);
+    }
+    
+    // Compare the installed package names against the blocklist and cache the result
+    JNIEXPORT jboolean JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeCheckPackages(
+            JNIEnv *env, jobject thiz, jobjectArray installed) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return JNI_FALSE;
+        
+        jsize count = installed ? env->GetArrayLength(installed) : 0;
+        std::vector<std::string> names;
+        names.reserve(count);
+        for (jsize i = 0; i < count; i++) {
+            jstring name = static_cast<jstring>(env->GetObjectArrayElement(installed, i));
+            if (!name) continue;
+            const char* chars = env->GetStringUTFChars(name, nullptr);
+            if (chars) {
+                names.emplace_back(chars);
+                env->ReleaseStringUTFChars(name, chars);
+            }
+            env->DeleteLocalRef(name);
+        }
+        std::sort(names.begin(), names.end());
+        
+        const std::string* found = findCheatPackage(names);
+        if (found) {
+            LOGW("Cheat tool detected: %s", found->c_str());
+        }
+        ctx->cheatPackageInstalled.store(found != nullptr, std::memory_order_relaxed);
+        return found ? JNI_TRUE : JNI_FALSE;
+    }
+    
+    // RootSignal bits; probes run on the first call only
+    JNIEXPORT jint JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeGetRootSignals(
+            JNIEnv *env, jobject thiz) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return 0;
+        
+        return rootSignals(*ctx);
+    }
+    
+    // Replace the root probe table (null restores the default); probes run again
+    JNIEXPORT void JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeSetRootProbePaths(
+            JNIEnv *env, jobject thiz, jobjectArray paths) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return;
+        
+        std::vector<std::string> table;
+        jsize count = paths ? env->GetArrayLength(paths) : 0;
+        for (jsize i = 0; i < count; i++) {
+            jstring path = static_cast<jstring>(env->GetObjectArrayElement(paths, i));
+            if (!path) continue;
+            const char* chars = env->GetStringUTFChars(path, nullptr);
+            if (chars) {
+                table.emplace_back(chars);
+                env->ReleaseStringUTFChars(path, chars);
+            }
+            env->DeleteLocalRef(path);
+        }
+        
+        std::lock_guard<std::mutex> lock(ctx->mutex);
+        ctx->rootPaths.swap(table);
+        ctx->rootSignals.store(-1, std::memory_order_release);
+    }
+    
+    // Protect memory region
+    JNIEXPORT jlong JNICALL
     Java_com_stfugg_STFUGameGuardian_nativeProtectMemoryRegion(
             JNIEnv *env, jobject thiz, jlong address, jint size) {
-        std::lock_guard<std::mutex> lock(g_mutex);
+        ContextRef ctx(env, thiz);
+        if (!ctx) return 0;
+        
+        std::lock_guard<std::mutex> lock(ctx->mutex);
         
         void* addr = reinterpret_cast<void*>(address);
+        if (!addr || size <= 0 || !ensureSessionState(*ctx)) {
+            return 0;
+        }
+        
+        std::unique_ptr<ShieldRegion> entry(new ShieldRegion());
+        entry->context = ctx;
+        MemoryRegion* region = &entry->region;
+        region->address = addr;
+        region->size = static_cast<size_t>(size);
+        region->mode = ctx->integrityMode;
+        region->mapping = regionMapping(*ctx, addr, region->size);
+        region->valid = true;
         
-        MemoryRegion region;
-        region.address = addr;
-        region.size = static_cast<size_t>(size);
-        region.checksum = calculateChecksum(addr, size);
-        region.valid = true;
+        int64_t id = handleCreate(HANDLE_REGION, entry.get(), ctx);
+        if (!id) {
+            LOGE("No handle left for memory region %p", addr);
+            return 0;
+        }
+        
+        // Joins the caller's protection batch if one is open
+        SealedBatch batch(ctx->sealedTable);
+        if (!sealRegion(ctx->sealedTable, *region, hashThreadCount())) {
+            LOGE("No room to protect memory region %p", addr);
+            handleRetire(id);
+            return 0;
+        }
         
-        g_memoryRegions.push_back(region);
+        ctx->regions.push_back(std::move(entry));
         
         LOGI("Protected memory region: %p, size: %u", addr, size);
+        return id;
+    }
+    
+    // Allocate a zeroed block protected like a region, for whole structs
+    JNIEXPORT jlong JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeProtectBytes(
+            JNIEnv *env, jobject thiz, jint size) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return 0;
+        
+        std::lock_guard<std::mutex> lock(ctx->mutex);
+        
+        if (size <= 0 || !ensureSessionState(*ctx)) {
+            return 0;
+        }
+        
+        void* block = mmap(nullptr, static_cast<size_t>(size), PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (block == MAP_FAILED) {
+            LOGE("Failed to map protected block of %d bytes", size);
+            return 0;
+        }
+        
+        std::unique_ptr<ShieldRegion> entry(new ShieldRegion());
+        entry->context = ctx;
+        MemoryRegion* region = &entry->region;
+        region->address = block;
+        region->size = static_cast<size_t>(size);
+        region->mode = ctx->integrityMode;
+        region->valid = true;
+        region->owned = true;
+        region->mapping = MAPPING_ANONYMOUS;
+        
+        int64_t id = handleCreate(HANDLE_REGION, entry.get(), ctx);
+        if (!id) {
+            LOGE("No handle left for block of %d bytes", size);
+            munmap(block, region->size);
+            return 0;
+        }
+        
+        SealedBatch batch(ctx->sealedTable);
+        if (!sealRegion(ctx->sealedTable, *region, hashThreadCount())) {
+            LOGE("No room to protect block of %d bytes", size);
+            handleRetire(id);
+            munmap(block, region->size);
+            return 0;
+        }
+        
+        ctx->regions.push_back(std::move(entry));
+        return id;
+    }
+    
+    // Zero-copy view of a protected block; writes through it must be
+    // bracketed by nativeBeginRegionWrite/nativeEndRegionWrite. The view
+    // outlives the handle check, so it must not be used after nativeDestroy.
+    JNIEXPORT jobject JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeGetBytesBuffer(
+            JNIEnv *env, jobject thiz, jlong handle) {
+        HandleRef ref(handle, HANDLE_REGION);
+        ShieldRegion* entry = regionOf(env, thiz, ref);
+        if (!entry || !entry->region.owned) return nullptr;
+        return env->NewDirectByteBuffer(entry->region.address, static_cast<jlong>(entry->region.size));
+    }
+    
+    // Verified bulk read: false if the bytes read don't match the baseline
+    JNIEXPORT jboolean JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeReadBytes(
+            JNIEnv *env, jobject thiz, jlong handle, jint offset, jbyteArray out) {
+        HandleRef ref(handle, HANDLE_REGION);
+        ShieldRegion* entry = regionOf(env, thiz, ref);
+        if (!entry || !out || offset < 0) return JNI_FALSE;
+        
+        // Leaves are checked and held before entering the critical section,
+        // which must not wait on other threads
+        size_t start = static_cast<size_t>(offset);
+        size_t length = static_cast<size_t>(env->GetArrayLength(out));
+        if (start > entry->region.size) return JNI_FALSE;
+        if (length == 0) return JNI_TRUE; // Nothing read, nothing to verify
+        if (!beginRegionRead(entry->context->sealedTable, entry->region, start, length)) {
+            return JNI_FALSE;
+        }
+        void* data = env->GetPrimitiveArrayCritical(out, nullptr);
+        if (data) {
+            memcpy(data, static_cast<uint8_t*>(entry->region.address) + start, length);
+            env->ReleasePrimitiveArrayCritical(out, data, 0);
+        }
+        endRegionRead(entry->region, start, length);
+        return data ? JNI_TRUE : JNI_FALSE;
+    }
+    
+    // Bulk write folded into the baseline with one re-hash of the touched
+    // leaves. Costs that re-hash and no syscall: the new baselines are
+    // staged until the next check seals them.
+    JNIEXPORT jboolean JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeWriteBytes(
+            JNIEnv *env, jobject thiz, jlong handle, jint offset, jbyteArray data) {
+        HandleRef ref(handle, HANDLE_REGION);
+        ShieldRegion* entry = regionOf(env, thiz, ref);
+        if (!entry || !data || offset < 0) return JNI_FALSE;
+        
+        // As in nativeReadBytes, the leaves are held outside the critical section
+        size_t start = static_cast<size_t>(offset);
+        size_t length = static_cast<size_t>(env->GetArrayLength(data));
+        if (start > entry->region.size) return JNI_FALSE;
+        if (length == 0) return JNI_TRUE;
+        if (!beginRegionWrite(entry->context->sealedTable, entry->region, start, length)) return JNI_FALSE;
+        void* bytes = env->GetPrimitiveArrayCritical(data, nullptr);
+        if (bytes) {
+            memcpy(static_cast<uint8_t*>(entry->region.address) + start, bytes, length);
+            env->ReleasePrimitiveArrayCritical(data, bytes, JNI_ABORT);
+        }
+        bool ended = endRegionWrite(entry->context->sealedTable, entry->region, start, length);
+        return bytes && ended ? JNI_TRUE : JNI_FALSE;
+    }
+    
+    // Create an encrypted-at-rest vault of `size` zero bytes
+    JNIEXPORT jlong JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeCreateVault(
+            JNIEnv *env, jobject thiz, jint size) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return 0;
+        
+        std::lock_guard<std::mutex> lock(ctx->mutex);
+        
+        if (size <= 0 || !ensureSessionState(*ctx)) {
+            return 0;
+        }
+        
+        uint32_t key[8];
+        for (auto& word : key) {
+            word = static_cast<uint32_t>(ctx->rng());
+        }
+        uint64_t nonce = (static_cast<uint64_t>(ctx->rng()) << 32) | ctx->rng();
+        
+        std::unique_ptr<Vault> vault(new Vault());
+        bool created = vaultCreate(*vault, static_cast<size_t>(size), key, nonce);
+        memset(key, 0, sizeof(key));
+        if (!created) {
+            LOGE("Failed to create vault of %d bytes", size);
+            return 0;
+        }
+        
+        int64_t id = handleCreate(HANDLE_VAULT, vault.get(), ctx);
+        if (!id) {
+            LOGE("No handle left for vault of %d bytes", size);
+            vaultDestroy(*vault);
+            return 0;
+        }
+        
+        LOGI("Created vault: %d bytes, cipher %d", size, vaultCipher());
+        ctx->vaults.push_back(std::move(vault));
+        return id;
+    }
+    
+    // Decrypt vault bytes into out
+    JNIEXPORT jboolean JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeVaultRead(
+            JNIEnv *env, jobject thiz, jlong handle, jint offset, jbyteArray out) {
+        HandleRef ref(handle, HANDLE_VAULT);
+        Vault* vault = vaultOf(env, thiz, ref);
+        if (!vault || !out || offset < 0) return JNI_FALSE;
+        
+        jsize length = env->GetArrayLength(out);
+        void* data = env->GetPrimitiveArrayCritical(out, nullptr);
+        if (!data) return JNI_FALSE;
+        
+        bool read = vaultRead(*vault, static_cast<size_t>(offset), data, static_cast<size_t>(length));
+        env->ReleasePrimitiveArrayCritical(out, data, read ? 0 : JNI_ABORT);
+        return read ? JNI_TRUE : JNI_FALSE;
+    }
+    
+    // Encrypt data into the vault
+    JNIEXPORT jboolean JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeVaultWrite(
+            JNIEnv *env, jobject thiz, jlong handle, jint offset, jbyteArray data) {
+        HandleRef ref(handle, HANDLE_VAULT);
+        Vault* vault = vaultOf(env, thiz, ref);
+        if (!vault || !data || offset < 0) return JNI_FALSE;
+        
+        jsize length = env->GetArrayLength(data);
+        void* bytes = env->GetPrimitiveArrayCritical(data, nullptr);
+        if (!bytes) return JNI_FALSE;
+        
+        bool written = vaultWrite(*vault, static_cast<size_t>(offset), bytes, static_cast<size_t>(length));
+        env->ReleasePrimitiveArrayCritical(data, bytes, JNI_ABORT);
+        return written ? JNI_TRUE : JNI_FALSE;
     }
     
     // Check if protected memory has been tampered
     JNIEXPORT jboolean JNICALL
     Java_com_stfugg_STFUGameGuardian_nativeCheckProtectedMemory(
             JNIEnv *env, jobject thiz) {
-        std::lock_guard<std::mutex> lock(g_mutex);
+        ContextRef ctx(env, thiz);
+        if (!ctx) return JNI_FALSE;
         
-        for (auto& region : g_memoryRegions) {
-            if (!region.valid) continue;
+        ScopedCpuPlacement placement(CPU_PLACEMENT_BACKGROUND,
+                                     ctx->cpuPlacement.load(std::memory_order_relaxed));
+        ScopedPerfCounters counters(detectorStats(*ctx, DETECTOR_MEMORY));
+        
+        std::lock_guard<std::mutex> lock(ctx->mutex);
+        
+        // A write left open exempts its leaves from every check
+        for (auto& entry : ctx->regions) {
+            if (regionWritesStuck(entry->region)) {
+                LOGW("Protected region write left open at %p", entry->region.address);
+                return JNI_TRUE;
+            }
+        }
+        
+        // Fold baselines staged by game writes since the last check into
+        // the sealed table, unsealing it once for all of them
+        bool staged = false;
+        for (auto& entry : ctx->regions) {
+            staged |= regionWritesStaged(entry->region);
+        }
+        if (staged) {
+            SealedBatch batch(ctx->sealedTable);
+            for (auto& entry : ctx->regions) {
+                mergeRegionWrites(ctx->sealedTable, entry->region);
+            }
+        }
+        
+        if (ctx->snapshotMode) {
+            // Report the last snapshot's verdict, then start the next one
+            MemoryRegion* tampered = nullptr;
+            SnapshotResult result = snapshotPoll(ctx->snapshot, &tampered);
+            if (result == SNAPSHOT_TAMPERED) {
+                LOGW("Memory tampering detected at %p (snapshot)", tampered->address);
+                return JNI_TRUE;
+            }
+            if (result == SNAPSHOT_FAILED) {
+                LOGW("Snapshot verifier did not finish");
+            }
             
-            uint32_t currentChecksum = calculateChecksum(region.address, region.size);
-            if (currentChecksum != region.checksum) {
-                LOGW("Memory tampering detected at %p", region.address);
+            if (result != SNAPSHOT_PENDING && ctx->sealedTable.base) {
+                std::vector<MemoryRegion*> regions;
+                for (auto& entry : ctx->regions) {
+                    if (entry->region.valid) regions.push_back(&entry->region);
+                }
+                snapshotStart(ctx->snapshot, ctx->sealedTable, regions);
+            }
+        } else {
+            // One address-ordered pass over every region
+            std::vector<MemoryRegion*> regions;
+            for (auto& entry : ctx->regions) {
+                if (entry->region.valid) regions.push_back(&entry->region);
+            }
+            MemoryRegion* tampered = nullptr;
+            if (!verifyRegions(ctx->sealedTable, regions, hashThreadCount(), &tampered)) {
+                LOGW("Memory tampering detected at %p", tampered->address);
                 return JNI_TRUE;
             }
         }
         
+        // Move baselines to fresh pages now and then; skipped if a batch is open
+        if (ctx->sealedTable.base && ++ctx->checksSinceRelocation >= kSealedRelocateInterval) {
+            if (sealedTableRelocate(ctx->sealedTable, randomMappingHint(*ctx))) {
+                ctx->checksSinceRelocation = 0;
+            }
+        }
+        
+        return JNI_FALSE;
+    }
+    
+    // Coalesce sealed table updates: registrations made between these calls
+    // unseal and reseal the table only once. Region writes never unseal it.
+    JNIEXPORT void JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeBeginProtectionBatch(
+            JNIEnv *env, jobject thiz) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return;
+        
+        std::lock_guard<std::mutex> lock(ctx->mutex);
+        if (ensureSessionState(*ctx)) {
+            sealedTableBeginBatch(ctx->sealedTable);
+        }
+    }
+    
+    JNIEXPORT void JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeEndProtectionBatch(
+            JNIEnv *env, jobject thiz) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return;
+        
+        sealedTableEndBatch(ctx->sealedTable);
+    }
+    
+    // Bracket a legitimate game write to a protected region
+    JNIEXPORT jboolean JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeBeginRegionWrite(
+            JNIEnv *env, jobject thiz, jlong handle, jint offset, jint size) {
+        HandleRef ref(handle, HANDLE_REGION);
+        ShieldRegion* entry = regionOf(env, thiz, ref);
+        if (!entry || offset < 0 || size < 0) return JNI_FALSE;
+        return beginRegionWrite(entry->context->sealedTable, entry->region, offset, size) ? JNI_TRUE : JNI_FALSE;
+    }
+    
+    // Re-hashes the written leaves into the region's staging area; no
+    // syscall, and the sealed table is updated at the next check
+    JNIEXPORT jboolean JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeEndRegionWrite(
+            JNIEnv *env, jobject thiz, jlong handle, jint offset, jint size) {
+        HandleRef ref(handle, HANDLE_REGION);
+        ShieldRegion* entry = regionOf(env, thiz, ref);
+        if (!entry || offset < 0 || size < 0) return JNI_FALSE;
+        return endRegionWrite(entry->context->sealedTable, entry->region, offset, size) ? JNI_TRUE : JNI_FALSE;
+    }
+    
+    // Select the integrity mode used for regions registered afterwards
+    JNIEXPORT void JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeSetIntegrityMode(
+            JNIEnv *env, jobject thiz, jint mode) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return;
+        
+        std::lock_guard<std::mutex> lock(ctx->mutex);
+        
+        if (mode != INTEGRITY_CHECKSUM && mode != INTEGRITY_KEYED_TREE) {
+            LOGW("Unknown integrity mode: %d", mode);
+            return;
+        }
+        ctx->integrityMode = mode;
+    }
+    
+    // Verify regions in a forked copy-on-write snapshot instead of in place.
+    // Each check then reports the previous snapshot's verdict.
+    JNIEXPORT void JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeSetSnapshotVerification(
+            JNIEnv *env, jobject thiz, jboolean enabled) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return;
+        
+        std::lock_guard<std::mutex> lock(ctx->mutex);
+        
+        ctx->snapshotMode = enabled == JNI_TRUE;
+        if (!ctx->snapshotMode) {
+            snapshotCancel(ctx->snapshot);
+        }
+    }
+    
+    // Run detectors on the efficiency cores at low priority, and attestation
+    // on the performance cores
+    JNIEXPORT void JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeSetCpuPlacement(
+            JNIEnv *env, jobject thiz, jboolean enabled) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return;
+        
+        ctx->cpuPlacement.store(enabled == JNI_TRUE, std::memory_order_relaxed);
+    }
+    
+    // Time the parent spent in the last snapshot fork
+    JNIEXPORT jlong JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeGetSnapshotForkNanos(
+            JNIEnv *env, jobject thiz) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return 0;
+        
+        std::lock_guard<std::mutex> lock(ctx->mutex);
+        return ctx->snapshot.lastForkNs;
+    }
+    
+    // SHA-256 of every input in one call; digests back to back
+    JNIEXPORT jbyteArray JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeSha256Batch(
+            JNIEnv *env, jobject thiz, jobjectArray inputs) {
+        if (!inputs) return nullptr;
+        jsize count = env->GetArrayLength(inputs);
+        
+        // Copy the inputs out first: one array at a time, no critical sections
+        std::vector<uint8_t> bytes;
+        std::vector<size_t> offsets(count);
+        std::vector<size_t> sizes(count);
+        for (jsize i = 0; i < count; i++) {
+            jbyteArray input = static_cast<jbyteArray>(env->GetObjectArrayElement(inputs, i));
+            jsize size = input ? env->GetArrayLength(input) : 0;
+            offsets[i] = bytes.size();
+            sizes[i] = static_cast<size_t>(size);
+            bytes.resize(bytes.size() + size);
+            if (size > 0) {
+                env->GetByteArrayRegion(input, 0, size, reinterpret_cast<jbyte*>(bytes.data() + offsets[i]));
+            }
+            if (input) env->DeleteLocalRef(input);
+        }
+        
+        std::vector<const uint8_t*> pointers(count);
+        for (jsize i = 0; i < count; i++) {
+            pointers[i] = bytes.data() + offsets[i];
+        }
+        std::vector<uint8_t> digests(count * kSha256DigestSize);
+        sha256Batch(pointers.data(), sizes.data(), count, digests.data());
+        
+        jbyteArray result = env->NewByteArray(static_cast<jsize>(digests.size()));
+        if (result) {
+            env->SetByteArrayRegion(result, 0, static_cast<jsize>(digests.size()),
+                                    reinterpret_cast<const jbyte*>(digests.data()));
+        }
+        return result;
+    }
+    
+    // Include a protected region in attestation; its contents must not change
+    JNIEXPORT jboolean JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeAddAttestationRegion(
+            JNIEnv *env, jobject thiz, jlong handle) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return JNI_FALSE;
+        
+        HandleRef ref(handle, HANDLE_REGION);
+        ShieldRegion* entry = regionOf(env, thiz, ref);
+        if (!entry || entry->region.size == 0) return JNI_FALSE;
+        
+        std::lock_guard<std::mutex> lock(ctx->mutex);
+        ctx->attestRegions.push_back(&entry->region);
+        return JNI_TRUE;
+    }
+    
+    // ABI of this library, so the server picks the matching reference image
+    JNIEXPORT jstring JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeGetAbi(
+            JNIEnv *env, jobject thiz) {
+#if defined(__aarch64__)
+        return env->NewStringUTF("arm64-v8a");
+#elif defined(__arm__)
+        return env->NewStringUTF("armeabi-v7a");
+#elif defined(__x86_64__)
+        return env->NewStringUTF("x86_64");
+#else
+        return env->NewStringUTF("x86");
+#endif
+    }
+    
+    // Answer a server nonce over code and attested regions; null if late
+    JNIEXPORT jbyteArray JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeAttest(
+            JNIEnv *env, jobject thiz, jbyteArray nonce, jint deadlineMicros) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return nullptr;
+        
+        // The server times the response; run it on the fast cores
+        ScopedCpuPlacement placement(CPU_PLACEMENT_DEADLINE,
+                                     ctx->cpuPlacement.load(std::memory_order_relaxed));
+        ScopedPerfCounters counters(detectorStats(*ctx, DETECTOR_ATTESTATION));
+        int64_t deadlineNs = monotonicNs() + static_cast<int64_t>(std::max(deadlineMicros, 0)) * 1000;
+        if (!nonce || env->GetArrayLength(nonce) != static_cast<jsize>(kAttestNonceSize)) {
+            return nullptr;
+        }
+        uint8_t nonceBytes[kAttestNonceSize];
+        env->GetByteArrayRegion(nonce, 0, kAttestNonceSize, reinterpret_cast<jbyte*>(nonceBytes));
+        
+        std::vector<AttestTarget> targets;
+        attestCodeTargets(targets);
+        uint8_t response[kAttestResponseSize];
+        AttestResult result;
+        {
+            std::lock_guard<std::mutex> lock(ctx->mutex);
+            for (MemoryRegion* region : ctx->attestRegions) {
+                targets.push_back({static_cast<const uint8_t*>(region->address), region->size});
+            }
+            result = attestTargets(targets, nonceBytes, deadlineNs, hashThreadCount(), response);
+        }
+        if (result != ATTEST_OK) {
+            LOGW("Attestation failed: %d", result);
+            return nullptr;
+        }
+        
+        jbyteArray out = env->NewByteArray(kAttestResponseSize);
+        if (out) {
+            env->SetByteArrayRegion(out, 0, kAttestResponseSize, reinterpret_cast<const jbyte*>(response));
+        }
+        return out;
+    }
+    
+    // Start the process-freeze watchdog, which also checks detector liveness
+    JNIEXPORT jboolean JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeStartStallWatchdog(
+            JNIEnv *env, jobject thiz, jint periodMs, jint thresholdMs) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return JNI_FALSE;
+        
+        std::lock_guard<std::mutex> lock(ctx->mutex);
+        if (stallWatchdogRunning(ctx->stallWatchdog)) return JNI_TRUE;
+        if (periodMs <= 0 || thresholdMs <= 0) return JNI_FALSE;
+        
+        // The Java check thread flags the watchdog if it stops ticking
+        int64_t periodNs = static_cast<int64_t>(periodMs) * 1000000;
+        int64_t thresholdNs = static_cast<int64_t>(thresholdMs) * 1000000;
+        ctx->watchdogSlot = livenessRegister(ctx->liveness, thresholdNs + periodNs);
+        if (ctx->watchdogSlot >= 0) {
+            JavaVM* vm = nullptr;
+            env->GetJavaVM(&vm);
+            g_javaVm.store(vm);
+            ctx->shieldRef = env->NewGlobalRef(thiz);
+            ctx->watchdogChecker = LivenessChecker();
+            ctx->stallWatchdog.onWake = watchdogTick;
+            ctx->stallWatchdog.onWakeArg = ctx;
+        }
+        
+        if (!stallWatchdogStart(ctx->stallWatchdog, periodNs, thresholdNs)) {
+            livenessUnregister(ctx->liveness, ctx->watchdogSlot);
+            ctx->watchdogSlot = -1;
+            ctx->stallWatchdog.onWake = nullptr;
+            if (ctx->shieldRef) {
+                env->DeleteGlobalRef(ctx->shieldRef);
+                ctx->shieldRef = nullptr;
+            }
+            return JNI_FALSE;
+        }
+        return JNI_TRUE;
+    }
+    
+    // Stop the process-freeze watchdog (e.g. while the game is backgrounded).
+    // Called from the thread that started it.
+    JNIEXPORT void JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeStopStallWatchdog(
+            JNIEnv *env, jobject thiz) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return;
+        
+        // Joined without the context mutex: the watchdog may be inside a Java callback
+        stallWatchdogStop(ctx->stallWatchdog);
+        
+        std::lock_guard<std::mutex> lock(ctx->mutex);
+        ctx->stallWatchdog.onWake = nullptr;
+        ctx->stallWatchdog.onWakeArg = nullptr;
+        livenessUnregister(ctx->liveness, ctx->watchdogSlot);
+        ctx->watchdogSlot = -1;
+        if (ctx->shieldRef) {
+            env->DeleteGlobalRef(ctx->shieldRef);
+            ctx->shieldRef = nullptr;
+        }
+    }
+    
+    // Claim a liveness slot for a detector thread; -1 if none are free
+    JNIEXPORT jint JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeRegisterLiveness(
+            JNIEnv *env, jobject thiz, jint deadlineMs) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return -1;
+        
+        return livenessRegister(ctx->liveness, static_cast<int64_t>(deadlineMs) * 1000000);
+    }
+    
+    JNIEXPORT void JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeUnregisterLiveness(
+            JNIEnv *env, jobject thiz, jint slot) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return;
+        
+        livenessUnregister(ctx->liveness, slot);
+    }
+    
+    // Mark a round of detector work done
+    JNIEXPORT void JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeLivenessBeat(
+            JNIEnv *env, jobject thiz, jint slot) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return;
+        
+        if (slot < 0 || slot >= static_cast<jint>(kLivenessSlots)) return;
+        livenessBeat(ctx->liveness, slot);
+    }
+    
+    // True if another detector thread (the watchdog) stopped making progress.
+    // maxGapMs is the caller's own check cadence.
+    JNIEXPORT jboolean JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeCheckLiveness(
+            JNIEnv *env, jobject thiz, jint self, jint maxGapMs) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return JNI_FALSE;
+        
+        uint32_t missed = livenessCheck(ctx->liveness, ctx->integrityChecker, self, monotonicNs(),
+                                        static_cast<int64_t>(maxGapMs) * 1000000);
+        if (missed) {
+            LOGW("Detector thread missed its deadline (slots 0x%x)", missed);
+            return JNI_TRUE;
+        }
         return JNI_FALSE;
     }
     
+    // True if the process was frozen since the last check
+    JNIEXPORT jboolean JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeCheckProcessStalls(
+            JNIEnv *env, jobject thiz) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return JNI_FALSE;
+        
+        std::lock_guard<std::mutex> lock(ctx->mutex);
+        uint64_t stalls = ctx->stallWatchdog.stalls.load(std::memory_order_relaxed);
+        if (stalls == ctx->reportedStalls) return JNI_FALSE;
+        
+        ctx->reportedStalls = stalls;
+        LOGW("Process freeze detected (longest %lld ms)",
+             static_cast<long long>(ctx->stallWatchdog.longestStallNs.load() / 1000000));
+        return JNI_TRUE;
+    }
+    
+    // Watchdog wake lateness histogram, log2 ms buckets
+    JNIEXPORT jlongArray JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeGetStallHistogram(
+            JNIEnv *env, jobject thiz) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return nullptr;
+        
+        jlong counts[kStallBuckets];
+        for (size_t i = 0; i < kStallBuckets; i++) {
+            counts[i] = static_cast<jlong>(ctx->stallWatchdog.histogram[i].load(std::memory_order_relaxed));
+        }
+        
+        jlongArray result = env->NewLongArray(kStallBuckets);
+        if (result) {
+            env->SetLongArrayRegion(result, 0, kStallBuckets, counts);
+        }
+        return result;
+    }
+    
+    // Count cycles, instructions, cache misses, page faults and context
+    // switches of each detector run
+    JNIEXPORT void JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeSetPerfCounters(
+            JNIEnv *env, jobject thiz, jboolean enabled) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return;
+        
+        ctx->perfCounters.store(enabled == JNI_TRUE, std::memory_order_relaxed);
+    }
+    
+    // Totals of one detector's runs, laid out as detectorStatsRead() fills them
+    JNIEXPORT jlongArray JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeGetDetectorStats(
+            JNIEnv *env, jobject thiz, jint detector) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return nullptr;
+        if (detector < 0 || static_cast<size_t>(detector) >= kDetectors) return nullptr;
+        
+        int64_t stats[kDetectorStatsFields];
+        detectorStatsRead(ctx->detectorStats[detector], stats);
+        jlong values[kDetectorStatsFields];
+        std::copy(stats, stats + kDetectorStatsFields, values);
+        
+        jlongArray result = env->NewLongArray(kDetectorStatsFields);
+        if (result) {
+            env->SetLongArrayRegion(result, 0, kDetectorStatsFields, values);
+        }
+        return result;
+    }
+    
     // Check if protected values have been tampered
     JNIEXPORT jboolean JNICALL
     Java_com_stfugg_STFUGameGuardian_nativeCheckProtectedValues(
             JNIEnv *env, jobject thiz) {
-        // Implementation would verify checksums for all protected values
-        // This is a simplified version
+        ContextRef ctx(env, thiz);
+        if (!ctx) return JNI_FALSE;
+        
+        ScopedCpuPlacement placement(CPU_PLACEMENT_BACKGROUND,
+                                     ctx->cpuPlacement.load(std::memory_order_relaxed));
+        ScopedPerfCounters counters(detectorStats(*ctx, DETECTOR_VALUES));
+        
+        // Any edit to a decoy means a memory tool found and poked it
+        if (!decoyEngineVerify(ctx->decoys)) {
+            LOGW("Decoy value tampering detected");
+            return JNI_TRUE;
+        }
+        
+        // Move a batch of values so pinned addresses go stale
+        int64_t budget = ctx->relocationBudgetNs.load(std::memory_order_relaxed);
+        if (budget > 0) {
+            valueStoreRelocate(ctx->valueStore, budget);
+        }
+        
+        // A redundant copy outvoted since the last check was edited in place
+        uint64_t faults = ctx->valueStore.redundancyFaults.load(std::memory_order_relaxed);
+        if (ctx->reportedRedundancyFaults.exchange(faults) != faults) {
+            LOGW("Redundant value copy tampering detected");
+            return JNI_TRUE;
+        }
+        
         return JNI_FALSE;
     }
     
+    // Plant plaintext decoys that mirror a protected value
+    JNIEXPORT jint JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeAddDecoys(
+            JNIEnv *env, jobject thiz, jlong ptr, jint copies) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return 0;
+        
+        uint64_t bits;
+        if (copies <= 0 || !valueStoreGet(ctx->valueStore, ptr, &bits)) {
+            return 0;
+        }
+        return decoyEngineAdd(ctx->decoys, ptr, bits, copies);
+    }
+    
+    // Time budget per check for relocating protected values (0 disables)
+    JNIEXPORT void JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeSetValueRelocationBudget(
+            JNIEnv *env, jobject thiz, jint micros) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return;
+        
+        ctx->relocationBudgetNs.store(static_cast<int64_t>(std::max(micros, 0)) * 1000,
+                                   std::memory_order_relaxed);
+    }
+    
+    // Start or pause recording value changes for server replay
+    JNIEXPORT void JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeSetJournalEnabled(
+            JNIEnv *env, jobject thiz, jboolean enabled) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return;
+        
+        journalSetEnabled(ctx->journal, enabled);
+    }
+    
+    // Tag the calling thread's following journal records
+    JNIEXPORT void JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeSetJournalTag(
+            JNIEnv *env, jobject thiz, jint tag) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return;
+        
+        journalSetTag(ctx->journal, static_cast<uint16_t>(tag));
+    }
+    
+    // Drain the journal in its wire format; null when there is nothing to send
+    JNIEXPORT jbyteArray JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeDrainJournal(
+            JNIEnv *env, jobject thiz) {
+        ContextRef ctx(env, thiz);
+        if (!ctx) return nullptr;
+        
+        // Records appended after this count wait for the next drain
+        size_t pending = journalPending(ctx->journal);
+        if (pending == 0 && ctx->journal.dropped.load(std::memory_order_relaxed) == 0) {
+            return nullptr;
+        }
+        
+        // Drained into a native buffer first: draining takes the journal
+        // mutex, which must not be waited on inside a critical section. A
+        // concurrent drain may take some of the records, so the array is
+        // sized to what was actually drained.
+        std::vector<uint8_t> buffer(sizeof(JournalHeader) + pending * sizeof(JournalRecord));
+        size_t size = journalDrain(ctx->journal, buffer.data(), pending);
+        
+        jbyteArray out = env->NewByteArray(static_cast<jsize>(size));
+        if (!out) return nullptr;
+        env->SetByteArrayRegion(out, 0, static_cast<jsize>(size), reinterpret_cast<const jbyte*>(buffer.data()));
+        return out;
+    }
+    
     // Apply countermeasures
     JNIEXPORT void JNICALL
     Java_com_stfugg_STFUGameGuardian_nativeApplyCountermeasures(
@@ -286,19 +1589,64 @@ extern "C" {
         }
     }
     
-    // Cleanup resources
+    // Release this instance's context. Its handle is cleared and retired
+    // first: calls that start later see no context, and calls already
+    // running (value accessors on game threads, a check waiting on the
+    // context mutex) finish before anything is freed. Region and vault
+    // handles are retired the same way.
     JNIEXPORT void JNICALL
     Java_com_stfugg_STFUGameGuardian_nativeDestroy(
             JNIEnv *env, jobject thiz) {
-        std::lock_guard<std::mutex> lock(g_mutex);
+        int64_t handle = contextHandle(env, thiz);
+        ShieldContext* ctx;
+        {
+            HandleRef ref(handle, HANDLE_CONTEXT);
+            ctx = static_cast<ShieldContext*>(ref.object);
+        }
+        if (!ctx) return;
+        env->SetLongField(thiz, g_contextField.load(), 0);
+        
+        // Of concurrent destroys, only the one that retires the handle frees
+        if (!handleRetire(handle)) return;
         
-        // Free all allocated memory
-        for (auto& ptr : g_protectedPtrs) {
-            free(ptr.second);
+        {
+            // Writers waiting on a unit held by an open write give up, so
+            // retiring cannot wait on an end that will never resolve
+            std::lock_guard<std::mutex> lock(ctx->mutex);
+            for (auto& entry : ctx->regions) {
+                entry->region.retired.store(true, std::memory_order_relaxed);
+            }
+        }
+        handleRetireOwner(ctx);
+        
+        stallWatchdogStop(ctx->stallWatchdog);
+        if (ctx->shieldRef) {
+            env->DeleteGlobalRef(ctx->shieldRef);
+        }
+        {
+            std::lock_guard<std::mutex> lock(ctx->mutex);
+            
+            // Free all allocated memory
+            snapshotCancel(ctx->snapshot);
+            valueStoreDestroy(ctx->valueStore);
+            decoyEngineDestroy(ctx->decoys);
+            journalDestroy(ctx->journal);
+            for (auto& entry : ctx->regions) {
+                if (entry->region.owned) {
+                    munmap(entry->region.address, entry->region.size);
+                }
+            }
+            for (auto& vault : ctx->vaults) {
+                vaultDestroy(*vault);
+            }
+            sealedTableDestroy(ctx->sealedTable);
+            packageWatchStop(ctx->packageWatch);
         }
-        g_protectedPtrs.clear();
-        g_memoryRegions.clear();
-        g_initialized = false;
+        {
+            std::lock_guard<std::mutex> procLock(ctx->procMutex);
+            if (ctx->procReaderReady) procReaderDestroy(ctx->procReader);
+        }
+        delete ctx;
         
         LOGI("Native resources cleaned up");
     }
@@ -307,119 +1655,181 @@ extern "C" {
     JNIEXPORT jlong JNICALL
     Java_com_stfugg_STFUGameGuardian_nativeProtectInt(
             JNIEnv *env, jobject thiz, jint value) {
-        int* ptr = new int(value);
-        long id = reinterpret_cast<long>(ptr);
-        g_protectedPtrs[id] = ptr;
-        return id;
+        return protectBits(ContextRef(env, thiz), toBits<jint>(value));
     }
     
     JNIEXPORT jint JNICALL
     Java_com_stfugg_STFUGameGuardian_nativeGetInt(
             JNIEnv *env, jobject thiz, jlong ptr) {
-        int* valuePtr = reinterpret_cast<int*>(ptr);
-        return *valuePtr;
+        return fromBits<jint>(getBits(ContextRef(env, thiz), ptr));
     }
     
     JNIEXPORT void JNICALL
     Java_com_stfugg_STFUGameGuardian_nativeSetInt(
             JNIEnv *env, jobject thiz, jlong ptr, jint value) {
-        int* valuePtr = reinterpret_cast<int*>(ptr);
-        *valuePtr = value;
+        setValue<jint>(ContextRef(env, thiz), ptr, value);
+    }
+    
+    JNIEXPORT jint JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeAddInt(
+            JNIEnv *env, jobject thiz, jlong ptr, jint delta) {
+        return addValue<jint>(ContextRef(env, thiz), ptr, delta);
+    }
+    
+    // Bounded adds for currency and counters: one atomic update, no wrap
+    JNIEXPORT jint JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeClampAddInt(
+            JNIEnv *env, jobject thiz, jlong ptr, jint delta, jint min, jint max) {
+        return clampAddValue<jint>(ContextRef(env, thiz), ptr, delta, min, max);
+    }
+    
+    JNIEXPORT jboolean JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeTryAddInt(
+            JNIEnv *env, jobject thiz, jlong ptr, jint delta, jint min, jint max) {
+        return tryAddValue<jint>(ContextRef(env, thiz), ptr, delta, min, max);
+    }
+    
+    JNIEXPORT jboolean JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeCompareAndSetInt(
+            JNIEnv *env, jobject thiz, jlong ptr, jint expected, jint desired) {
+        return compareAndSetValue<jint>(ContextRef(env, thiz), ptr, expected, desired);
     }
     
     // Protected value methods - LONG
     JNIEXPORT jlong JNICALL
     Java_com_stfugg_STFUGameGuardian_nativeProtectLong(
             JNIEnv *env, jobject thiz, jlong value) {
-        long* ptr = new long(value);
-        long id = reinterpret_cast<long>(ptr);
-        g_protectedPtrs[id] = ptr;
-        return id;
+        return protectBits(ContextRef(env, thiz), toBits<jlong>(value));
+    }
+    
+    // Three copies voted on every read; get/set use the plain LONG methods
+    JNIEXPORT jlong JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeProtectRedundantLong(
+            JNIEnv *env, jobject thiz, jlong value) {
+        return protectBits(ContextRef(env, thiz), toBits<jlong>(value), true);
     }
     
     JNIEXPORT jlong JNICALL
     Java_com_stfugg_STFUGameGuardian_nativeGetLong(
             JNIEnv *env, jobject thiz, jlong ptr) {
-        long* valuePtr = reinterpret_cast<long*>(ptr);
-        return *valuePtr;
+        return fromBits<jlong>(getBits(ContextRef(env, thiz), ptr));
     }
     
     JNIEXPORT void JNICALL
     Java_com_stfugg_STFUGameGuardian_nativeSetLong(
             JNIEnv *env, jobject thiz, jlong ptr, jlong value) {
-        long* valuePtr = reinterpret_cast<long*>(ptr);
-        *valuePtr = value;
+        setValue<jlong>(ContextRef(env, thiz), ptr, value);
+    }
+    
+    JNIEXPORT jlong JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeAddLong(
+            JNIEnv *env, jobject thiz, jlong ptr, jlong delta) {
+        return addValue<jlong>(ContextRef(env, thiz), ptr, delta);
+    }
+    
+    // Bounded adds for currency and counters: one atomic update, no wrap
+    JNIEXPORT jlong JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeClampAddLong(
+            JNIEnv *env, jobject thiz, jlong ptr, jlong delta, jlong min, jlong max) {
+        return clampAddValue<jlong>(ContextRef(env, thiz), ptr, delta, min, max);
+    }
+    
+    JNIEXPORT jboolean JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeTryAddLong(
+            JNIEnv *env, jobject thiz, jlong ptr, jlong delta, jlong min, jlong max) {
+        return tryAddValue<jlong>(ContextRef(env, thiz), ptr, delta, min, max);
+    }
+    
+    JNIEXPORT jboolean JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeCompareAndSetLong(
+            JNIEnv *env, jobject thiz, jlong ptr, jlong expected, jlong desired) {
+        return compareAndSetValue<jlong>(ContextRef(env, thiz), ptr, expected, desired);
     }
     
     // Protected value methods - FLOAT
     JNIEXPORT jlong JNICALL
     Java_com_stfugg_STFUGameGuardian_nativeProtectFloat(
             JNIEnv *env, jobject thiz, jfloat value) {
-        float* ptr = new float(value);
-        long id = reinterpret_cast<long>(ptr);
-        g_protectedPtrs[id] = ptr;
-        return id;
+        return protectBits(ContextRef(env, thiz), toBits<jfloat>(value));
     }
     
     JNIEXPORT jfloat JNICALL
     Java_com_stfugg_STFUGameGuardian_nativeGetFloat(
             JNIEnv *env, jobject thiz, jlong ptr) {
-        float* valuePtr = reinterpret_cast<float*>(ptr);
-        return *valuePtr;
+        return fromBits<jfloat>(getBits(ContextRef(env, thiz), ptr));
     }
     
     JNIEXPORT void JNICALL
     Java_com_stfugg_STFUGameGuardian_nativeSetFloat(
             JNIEnv *env, jobject thiz, jlong ptr, jfloat value) {
-        float* valuePtr = reinterpret_cast<float*>(ptr);
-        *valuePtr = value;
+        setValue<jfloat>(ContextRef(env, thiz), ptr, value);
+    }
+    
+    JNIEXPORT jfloat JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeAddFloat(
+            JNIEnv *env, jobject thiz, jlong ptr, jfloat delta) {
+        return addValue<jfloat>(ContextRef(env, thiz), ptr, delta);
+    }
+    
+    JNIEXPORT jboolean JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeCompareAndSetFloat(
+            JNIEnv *env, jobject thiz, jlong ptr, jfloat expected, jfloat desired) {
+        return compareAndSetValue<jfloat>(ContextRef(env, thiz), ptr, expected, desired);
     }
     
     // Protected value methods - DOUBLE
     JNIEXPORT jlong JNICALL
     Java_com_stfugg_STFUGameGuardian_nativeProtectDouble(
             JNIEnv *env, jobject thiz, jdouble value) {
-        double* ptr = new double(value);
-        long id = reinterpret_cast<long>(ptr);
-        g_protectedPtrs[id] = ptr;
-        return id;
+        return protectBits(ContextRef(env, thiz), toBits<jdouble>(value));
     }
     
     JNIEXPORT jdouble JNICALL
     Java_com_stfugg_STFUGameGuardian_nativeGetDouble(
             JNIEnv *env, jobject thiz, jlong ptr) {
-        double* valuePtr = reinterpret_cast<double*>(ptr);
-        return *valuePtr;
+        return fromBits<jdouble>(getBits(ContextRef(env, thiz), ptr));
     }
     
     JNIEXPORT void JNICALL
     Java_com_stfugg_STFUGameGuardian_nativeSetDouble(
             JNIEnv *env, jobject thiz, jlong ptr, jdouble value) {
-        double* valuePtr = reinterpret_cast<double*>(ptr);
-        *valuePtr = value;
+        setValue<jdouble>(ContextRef(env, thiz), ptr, value);
+    }
+    
+    JNIEXPORT jdouble JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeAddDouble(
+            JNIEnv *env, jobject thiz, jlong ptr, jdouble delta) {
+        return addValue<jdouble>(ContextRef(env, thiz), ptr, delta);
+    }
+    
+    JNIEXPORT jboolean JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeCompareAndSetDouble(
+            JNIEnv *env, jobject thiz, jlong ptr, jdouble expected, jdouble desired) {
+        return compareAndSetValue<jdouble>(ContextRef(env, thiz), ptr, expected, desired);
     }
     
     // Protected value methods - BOOLEAN
     JNIEXPORT jlong JNICALL
     Java_com_stfugg_STFUGameGuardian_nativeProtectBoolean(
             JNIEnv *env, jobject thiz, jboolean value) {
-        bool* ptr = new bool(value);
-        long id = reinterpret_cast<long>(ptr);
-        g_protectedPtrs[id] = ptr;
-        return id;
+        return protectBits(ContextRef(env, thiz), toBits<jboolean>(value));
     }
     
     JNIEXPORT jboolean JNICALL
     Java_com_stfugg_STFUGameGuardian_nativeGetBoolean(
             JNIEnv *env, jobject thiz, jlong ptr) {
-        bool* valuePtr = reinterpret_cast<bool*>(ptr);
-        return *valuePtr;
+        return fromBits<jboolean>(getBits(ContextRef(env, thiz), ptr));
     }
     
     JNIEXPORT void JNICALL
     Java_com_stfugg_STFUGameGuardian_nativeSetBoolean(
             JNIEnv *env, jobject thiz, jlong ptr, jboolean value) {
-        bool* valuePtr = reinterpret_cast<bool*>(ptr);
-        *valuePtr = value;
+        setValue<jboolean>(ContextRef(env, thiz), ptr, value);
+    }
+    
+    JNIEXPORT jboolean JNICALL
+    Java_com_stfugg_STFUGameGuardian_nativeCompareAndSetBoolean(
+            JNIEnv *env, jobject thiz, jlong ptr, jboolean expected, jboolean desired) {
+        return compareAndSetValue<jboolean>(ContextRef(env, thiz), ptr, expected, desired);
     }
 }
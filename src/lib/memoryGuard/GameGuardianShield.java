@@ -1,21 +1,25 @@
 package com.gameguardianshield;
 
+import android.content.BroadcastReceiver;
 import android.content.Context;
+import android.content.Intent;
+import android.content.IntentFilter;
+import android.content.pm.PackageInfo;
 import android.content.pm.PackageManager;
 import android.os.Build;
 import android.os.Handler;
 import android.os.Looper;
+import android.os.SystemClock;
+import android.util.Base64;
 import android.util.Log;
 
 import java.io.BufferedReader;
-import java.io.File;
-import java.io.FileReader;
 import java.io.IOException;
 import java.io.OutputStream;
 import java.io.InputStreamReader;
 import java.net.HttpURLConnection;
 import java.net.URL;
-import java.security.MessageDigest;
+import java.nio.ByteBuffer;
 import java.util.ArrayList;
 import java.util.HashMap;
 import java.util.List;
@@ -24,7 +28,9 @@ import java.util.UUID;
 import java.util.concurrent.ExecutorService;
 import java.util.concurrent.Executors;
 import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicInteger;
 
+import org.json.JSONArray;
 import org.json.JSONException;
 import org.json.JSONObject;
 
@@ -35,16 +41,53 @@ import org.json.JSONObject;
 public class GameGuardianShield {
     private static final String TAG = "GameGuardianShield";
     
+    // Integrity modes for protected memory regions
+    public static final int INTEGRITY_MODE_CHECKSUM = 0;
+    public static final int INTEGRITY_MODE_KEYED = 1;
+    
+    // Root evidence bits from getRootSignals()
+    public static final int ROOT_SIGNAL_PATH = 1;               // su binary or root manager file present
+    public static final int ROOT_SIGNAL_SETUID = 2;             // a set-uid root binary among them
+    public static final int ROOT_SIGNAL_MOUNT = 4;              // root mounts or writable system partitions
+    public static final int ROOT_SIGNAL_SELINUX_PERMISSIVE = 8;
+    public static final int ROOT_SIGNAL_SELINUX_CONTEXT = 16;   // running in a root manager's domain
+    
+    // Detectors reported by getDetectorStats()
+    public static final int DETECTOR_MEMORY = 0;        // protected region checks
+    public static final int DETECTOR_VALUES = 1;        // protected value checks and decoys
+    public static final int DETECTOR_CHEAT_TOOLS = 2;   // detectCheatTools
+    public static final int DETECTOR_ATTESTATION = 3;
+    
+    // Stall watchdog heartbeat and the lateness that counts as a freeze
+    private static final int STALL_PERIOD_MS = 100;
+    private static final int STALL_THRESHOLD_MS = 750;
+    
+    // Slack on top of two check intervals before the check thread counts as stuck
+    private static final int LIVENESS_GRACE_MS = 5000;
+    
+    // Attestation time limit when the server does not set one: half a 60 Hz frame
+    private static final int ATTESTATION_DEADLINE_MICROS = 8000;
+    
+    // Value journal upload period, and drained chunks kept while the server is unreachable
+    private static final int JOURNAL_FLUSH_INTERVAL_MS = 30000;
+    private static final int MAX_UNSENT_JOURNAL_CHUNKS = 16;
+    
+    private static final char[] HEX_DIGITS = "0123456789abcdef".toCharArray();
+    
     // Native library
     static {
         System.loadLibrary("gameguardianshield"); // Load native library
     }
     
+    // Handle of this instance's native state, owned by the native library; 0 once destroyed
+    private long nativeContext;
+    
     // Shield configuration
     private Context context;
     private Handler mainHandler;
     private ExecutorService executorService;
     private Runnable integrityChecker;
+    private BroadcastReceiver packageReceiver;
     private boolean isProtectionActive = false;
     private CheatListener cheatListener;
     private String serverEndpoint;
@@ -52,6 +95,7 @@ public class GameGuardianShield {
     private int checkInterval = 2000; // Default: 2 seconds
     private int maxViolations = 3;
     private int currentViolations = 0;
+    private int livenessSlot = -1;
     private String uniqueId = null;
     private String playerId = null;
     private String sessionId = null;
@@ -59,6 +103,16 @@ public class GameGuardianShield {
     private final Map<String, Object> gameValues = new HashMap<>();
     private final List<String> memoryRegions = new ArrayList<>();
     
+    // Value journal; the executor thread owns the unsent chunks
+    private volatile boolean journalEnabled = false;
+    // Records were lost (journal off, new context, dropped chunks) each time
+    // this moves; the server is told until an upload after the loss succeeds
+    private final AtomicInteger journalGaps = new AtomicInteger(1);
+    private int journalGapsSent = 0;
+    private long lastJournalFlush = 0;
+    private final List<byte[]> unsentJournal = new ArrayList<>();
+    private final Map<Long, String> journalNames = new HashMap<>();
+    
     // Callbacks for cheat detection
     public interface CheatListener {
         void onCheatDetected(int severity, String type);
@@ -81,6 +135,7 @@ public class GameGuardianShield {
      * @param apiKey API key for authentication with server
      */
     public GameGuardianShield(Context context, String serverEndpoint, String apiKey) {
+        this.nativeContext = nativeCreateContext();
         this.context = context;
         this.serverEndpoint = serverEndpoint;
         this.apiKey = apiKey;
@@ -118,6 +173,13 @@ public class GameGuardianShield {
         Log.i(TAG, "Starting protection system");
         
         try {
+            // A destroyed shield starts over with a fresh native context,
+            // whose value handles the server has not seen
+            if (nativeContext == 0) {
+                nativeContext = nativeCreateContext();
+                journalGaps.incrementAndGet();
+            }
+            
             // Initialize native protection
             if (!initNativeProtection(context)) {
                 Log.e(TAG, "Failed to initialize native protection");
@@ -127,6 +189,14 @@ public class GameGuardianShield {
                 return false;
             }
             
+            // Watch for the process being frozen between checks, and for
+            // the check thread itself being suspended
+            nativeStartStallWatchdog(STALL_PERIOD_MS, STALL_THRESHOLD_MS);
+            livenessSlot = nativeRegisterLiveness(checkInterval * 2 + LIVENESS_GRACE_MS);
+            
+            // Recheck installed packages only when they change
+            registerPackageReceiver();
+            
             // Start the integrity checker
             isProtectionActive = true;
             mainHandler.post(integrityChecker);
@@ -148,6 +218,10 @@ public class GameGuardianShield {
         if (isProtectionActive) {
             isProtectionActive = false;
             mainHandler.removeCallbacks(integrityChecker);
+            nativeUnregisterLiveness(livenessSlot);
+            livenessSlot = -1;
+            nativeStopStallWatchdog();
+            unregisterPackageReceiver();
             Log.i(TAG, "Protection system deactivated");
         }
     }
@@ -386,6 +460,236 @@ public class GameGuardianShield {
         });
     }
     
+    /**
+     * Answer a server attestation challenge in the background. The server
+     * picks a nonce, the native library hashes the chunks of its code and of
+     * the attested regions that the nonce selects, and the server checks the
+     * answer against its reference images. A rejected answer is a violation.
+     */
+    public void runAttestation() {
+        if (serverEndpoint == null || apiKey == null) {
+            Log.w(TAG, "Cannot attest: Missing server endpoint or API key");
+            return;
+        }
+        
+        executorService.execute(new Runnable() {
+            @Override
+            public void run() {
+                try {
+                    JSONObject request = new JSONObject();
+                    request.put("playerId", playerId);
+                    request.put("sessionId", sessionId);
+                    request.put("abi", nativeGetAbi());
+                    JSONObject challenge = postJson("/api/attestation/challenge", request);
+                    if (challenge == null || !challenge.has("nonce")) {
+                        Log.e(TAG, "No attestation challenge from server");
+                        return;
+                    }
+                    
+                    byte[] nonce = Base64.decode(challenge.getString("nonce"), Base64.NO_WRAP);
+                    int deadlineMicros = challenge.optInt("deadlineMicros", ATTESTATION_DEADLINE_MICROS);
+                    byte[] response = nativeAttest(nonce, deadlineMicros);
+                    
+                    JSONObject answer = new JSONObject();
+                    answer.put("challengeId", challenge.getString("challengeId"));
+                    answer.put("playerId", playerId);
+                    answer.put("response", response != null
+                            ? Base64.encodeToString(response, Base64.NO_WRAP) : JSONObject.NULL);
+                    final JSONObject verdict = postJson("/api/attestation/response", answer);
+                    if (verdict == null) {
+                        Log.e(TAG, "No attestation verdict from server");
+                        return;
+                    }
+                    
+                    if ("invalid".equals(verdict.optString("status"))) {
+                        Log.w(TAG, "Server rejected attestation: " + verdict.optString("reason"));
+                        handleViolation("attestation_failed");
+                    }
+                    
+                    if (cheatListener != null) {
+                        mainHandler.post(new Runnable() {
+                            @Override
+                            public void run() {
+                                cheatListener.onServerResponse(verdict);
+                            }
+                        });
+                    }
+                } catch (Exception e) {
+                    Log.e(TAG, "Error running attestation", e);
+                }
+            }
+        });
+    }
+    
+    /**
+     * Record every change to protected values for replay on the server,
+     * which checks that each change starts from the value the previous one
+     * left and that values move no faster than the game's rules allow. The
+     * journal is uploaded with the integrity checks every
+     * JOURNAL_FLUSH_INTERVAL_MS; name the values the rules refer to with
+     * nameProtectedValue().
+     */
+    public void setValueJournalEnabled(boolean enabled) {
+        // Changes made while it was off are missing from the chains
+        if (enabled && !journalEnabled) {
+            journalGaps.incrementAndGet();
+        }
+        journalEnabled = enabled;
+        nativeSetJournalEnabled(enabled);
+    }
+    
+    /**
+     * Tag the calling thread's following value changes, e.g. with a game
+     * event ID (0-65535), so the server can tell purchases from rewards
+     */
+    public void setJournalTag(int tag) {
+        nativeSetJournalTag(tag);
+    }
+    
+    /**
+     * Name a protected value in the journal; names match the server's game
+     * rules, e.g. "coins" or "xp"
+     */
+    public void nameProtectedValue(ProtectedValue<?> value, String name) {
+        synchronized (journalNames) {
+            journalNames.put(value.nativePtr, name);
+        }
+    }
+    
+    /**
+     * Upload the value journal now instead of waiting for the next period
+     */
+    public void flushValueJournal() {
+        executorService.execute(new Runnable() {
+            @Override
+            public void run() {
+                sendValueJournal();
+            }
+        });
+    }
+    
+    /**
+     * Drain the native journal and upload it with any chunks a failed upload
+     * left behind. Runs on the executor thread.
+     */
+    private void sendValueJournal() {
+        lastJournalFlush = SystemClock.elapsedRealtime();
+        // A gap marked after this point may have lost records the drain
+        // below does not cover, so it stays pending past this upload
+        int gapsBeforeDrain = journalGaps.get();
+        byte[] chunk = nativeDrainJournal();
+        if (chunk != null) {
+            unsentJournal.add(chunk);
+        }
+        if (unsentJournal.isEmpty() || serverEndpoint == null || apiKey == null || playerId == null) {
+            return;
+        }
+        
+        // Dropping chunks leaves holes the server must not read as tampering
+        while (unsentJournal.size() > MAX_UNSENT_JOURNAL_CHUNKS) {
+            unsentJournal.remove(0);
+            journalGaps.incrementAndGet();
+            gapsBeforeDrain++; // Reported by this upload
+        }
+        
+        try {
+            JSONObject payload = new JSONObject();
+            payload.put("playerId", playerId);
+            payload.put("sessionId", sessionId);
+            payload.put("clientTimestamp", System.currentTimeMillis());
+            payload.put("gap", journalGaps.get() != journalGapsSent);
+            
+            JSONArray chunks = new JSONArray();
+            for (byte[] unsent : unsentJournal) {
+                chunks.put(Base64.encodeToString(unsent, Base64.NO_WRAP));
+            }
+            payload.put("journal", chunks);
+            
+            JSONObject names = new JSONObject();
+            synchronized (journalNames) {
+                for (Map.Entry<Long, String> entry : journalNames.entrySet()) {
+                    names.put(String.valueOf(entry.getKey()), entry.getValue());
+                }
+            }
+            payload.put("names", names);
+            
+            JSONObject verdict = postJson("/api/value-journal", payload);
+            if (verdict == null) {
+                return; // Kept for the next upload
+            }
+            unsentJournal.clear();
+            journalGapsSent = gapsBeforeDrain;
+            
+            if ("invalid".equals(verdict.optString("status"))) {
+                Log.w(TAG, "Server rejected value journal: " + verdict.optString("reason"));
+                handleViolation("impossible_value_change");
+            }
+        } catch (Exception e) {
+            Log.e(TAG, "Error sending value journal", e);
+        }
+    }
+    
+    /**
+     * POST a JSON payload to the server and parse the JSON reply; null when
+     * the server answers with an error status
+     */
+    private JSONObject postJson(String path, JSONObject payload) throws IOException, JSONException {
+        URL url = new URL(serverEndpoint + path);
+        HttpURLConnection connection = (HttpURLConnection) url.openConnection();
+        try {
+            connection.setRequestMethod("POST");
+            connection.setRequestProperty("Content-Type", "application/json");
+            connection.setRequestProperty("X-API-Key", apiKey);
+            connection.setDoOutput(true);
+            connection.setConnectTimeout(5000);
+            connection.setReadTimeout(5000);
+            
+            OutputStream os = connection.getOutputStream();
+            os.write(payload.toString().getBytes("UTF-8"));
+            os.close();
+            
+            int responseCode = connection.getResponseCode();
+            if (responseCode < 200 || responseCode >= 300) {
+                Log.e(TAG, "Request to " + path + " failed: " + responseCode);
+                return null;
+            }
+            
+            StringBuilder response = new StringBuilder();
+            try (BufferedReader br = new BufferedReader(
+                    new InputStreamReader(connection.getInputStream(), "utf-8"))) {
+                String responseLine;
+                while ((responseLine = br.readLine()) != null) {
+                    response.append(responseLine.trim());
+                }
+            }
+            return new JSONObject(response.toString());
+        } finally {
+            connection.disconnect();
+        }
+    }
+    
+    /**
+     * Answer an attestation nonce directly, for hosts with their own transport
+     * @param nonce 32 bytes from the server
+     * @param deadlineMicros time allowed; no answer is produced after it
+     * @return the 32-byte response, or null if the nonce is malformed or the
+     *         deadline passed
+     */
+    public byte[] attest(byte[] nonce, int deadlineMicros) {
+        return nativeAttest(nonce, deadlineMicros);
+    }
+    
+    /**
+     * Include a protected region in attestation, after the library code and
+     * any regions added before it. Only regions whose contents never change
+     * (level data, tuning tables) can be attested, and the server needs the
+     * same bytes as a reference image.
+     * @param handle handle from protectMemoryRegion() or protectBytes()
+     */
+    public boolean addAttestationRegion(long handle) {
+        return nativeAddAttestationRegion(handle);
+    }
+    
     /**
      * Apply server-provided values to local game state
      */
@@ -429,14 +733,12 @@ public class GameGuardianShield {
      */
     private String calculateChecksum(String input) {
         try {
-            MessageDigest digest = MessageDigest.getInstance("SHA-256");
-            byte[] hash = digest.digest(input.getBytes("UTF-8"));
-            StringBuilder hexString = new StringBuilder();
+            byte[] hash = sha256Batch(new byte[][] { input.getBytes("UTF-8") });
+            StringBuilder hexString = new StringBuilder(hash.length * 2);
             
             for (byte b : hash) {
-                String hex = Integer.toHexString(0xff & b);
-                if (hex.length() == 1) hexString.append('0');
-                hexString.append(hex);
+                hexString.append(HEX_DIGITS[(b >> 4) & 0xf]);
+                hexString.append(HEX_DIGITS[b & 0xf]);
             }
             
             return hexString.toString();
@@ -446,6 +748,16 @@ public class GameGuardianShield {
         }
     }
     
+    /**
+     * SHA-256 of every input in a single native call, hashing several inputs
+     * side by side (ARMv8 SHA2 / SHA-NI where available)
+     * @param inputs byte arrays to hash; null entries hash as empty
+     * @return the raw 32-byte digests, back to back in input order
+     */
+    public byte[] sha256Batch(byte[][] inputs) {
+        return nativeSha256Batch(inputs);
+    }
+    
     /**
      * Check system integrity
      */
@@ -456,7 +768,11 @@ public class GameGuardianShield {
                 boolean integrityFailed = false;
                 String detectionType = "";
                 
-                // Check for tampering tools
+                // Check for tampering tools; the installed package list is
+                // only compared again after a package change
+                if (nativePackagesChanged()) {
+                    refreshInstalledPackages();
+                }
                 if (detectCheatTools()) {
                     integrityFailed = true;
                     detectionType = "cheat_tool";
@@ -474,35 +790,71 @@ public class GameGuardianShield {
                     detectionType = "value_tampering";
                 }
                 
+                // Check for the process having been frozen (suspend-and-scan)
+                if (!integrityFailed && nativeCheckProcessStalls()) {
+                    integrityFailed = true;
+                    detectionType = "process_freeze";
+                }
+                
+                // Check that the watchdog thread is still running
+                if (!integrityFailed && nativeCheckLiveness(livenessSlot, checkInterval * 2)) {
+                    integrityFailed = true;
+                    detectionType = "detector_suspended";
+                }
+                
+                // This round is done; the watchdog expects the next in time
+                nativeLivenessBeat(livenessSlot);
+                
+                if (journalEnabled && SystemClock.elapsedRealtime() - lastJournalFlush >= JOURNAL_FLUSH_INTERVAL_MS) {
+                    sendValueJournal();
+                }
+                
                 // If integrity check failed, notify and apply countermeasures
                 if (integrityFailed) {
-                    currentViolations++;
-                    final int severity = (currentViolations >= maxViolations) ? 2 : 1; // 1=warning, 2=critical
-                    final String violationType = detectionType;
-                    
-                    // Apply countermeasures based on severity
-                    applyCountermeasures(severity, violationType);
-                    
-                    // Report to server if endpoint is configured
-                    if (serverEndpoint != null && apiKey != null) {
-                        reportViolationToServer(severity, violationType);
-                    }
-                    
-                    // Sync with server to verify game values
-                    if (playerId != null && serverEndpoint != null && apiKey != null) {
-                        syncGameValuesWithServer();
-                    }
-                    
-                    // Notify listener on main thread
-                    final int finalSeverity = severity;
-                    mainHandler.post(new Runnable() {
-                        @Override
-                        public void run() {
-                            if (cheatListener != null) {
-                                cheatListener.onCheatDetected(finalSeverity, violationType);
-                            }
-                        }
-                    });
+                    handleViolation(detectionType);
+                }
+            }
+        });
+    }
+    
+    /**
+     * Violation found by a native thread (e.g. the watchdog noticing the
+     * check thread is stuck). Called from native code.
+     */
+    private void onNativeViolation(String type) {
+        handleViolation(type);
+    }
+    
+    /**
+     * Count a violation, apply countermeasures and notify
+     */
+    private void handleViolation(final String violationType) {
+        final int severity;
+        synchronized (this) {
+            currentViolations++;
+            severity = (currentViolations >= maxViolations) ? 2 : 1; // 1=warning, 2=critical
+        }
+        
+        // Apply countermeasures based on severity
+        applyCountermeasures(severity, violationType);
+        
+        // Report to server if endpoint is configured
+        if (serverEndpoint != null && apiKey != null) {
+            reportViolationToServer(severity, violationType);
+        }
+        
+        // Sync with server to verify game values
+        if (playerId != null && serverEndpoint != null && apiKey != null) {
+            syncGameValuesWithServer();
+        }
+        
+        // Notify listener on main thread
+        final int finalSeverity = severity;
+        mainHandler.post(new Runnable() {
+            @Override
+            public void run() {
+                if (cheatListener != null) {
+                    cheatListener.onCheatDetected(finalSeverity, violationType);
                 }
             }
         });
@@ -596,6 +948,8 @@ public class GameGuardianShield {
             deviceInfo.put("device", Build.DEVICE);
             deviceInfo.put("brand", Build.BRAND);
             deviceInfo.put("sdkVersion", Build.VERSION.SDK_INT);
+            deviceInfo.put("rooted", isDeviceRooted());
+            deviceInfo.put("rootSignals", getRootSignals());
             deviceInfo.put("appVersion", context.getPackageManager().getPackageInfo(
                     context.getPackageName(), 0).versionName);
             return deviceInfo;
@@ -609,34 +963,57 @@ public class GameGuardianShield {
      * Check if device is rooted
      */
     private boolean isDeviceRooted() {
-        // Check common root directories
-        for (String path : new String[]{
-                "/system/app/Superuser.apk",
-                "/system/xbin/su",
-                "/system/bin/su",
-                "/sbin/su",
-                "/system/su",
-                "/system/bin/.ext/.su"}) {
-            if (new File(path).exists()) {
-                return true;
+        return nativeGetRootSignals() != 0;
+    }
+    
+    /**
+     * Relay package installs, updates and removals to the native package
+     * watch. Directory watches cover what broadcasts miss, such as changes
+     * while the receiver was unregistered.
+     */
+    private void registerPackageReceiver() {
+        if (packageReceiver != null) {
+            return;
+        }
+        packageReceiver = new BroadcastReceiver() {
+            @Override
+            public void onReceive(Context context, Intent intent) {
+                nativeNotifyPackagesChanged();
             }
+        };
+        IntentFilter filter = new IntentFilter();
+        filter.addAction(Intent.ACTION_PACKAGE_ADDED);
+        filter.addAction(Intent.ACTION_PACKAGE_REPLACED);
+        filter.addAction(Intent.ACTION_PACKAGE_REMOVED);
+        filter.addDataScheme("package");
+        context.registerReceiver(packageReceiver, filter);
+    }
+    
+    private void unregisterPackageReceiver() {
+        if (packageReceiver != null) {
+            context.unregisterReceiver(packageReceiver);
+            packageReceiver = null;
         }
-        
-        // Check for "su" command
-        Process process = null;
+    }
+    
+    /**
+     * Compare the installed packages against the native blocklist in one
+     * PackageManager call. On Android 11+ only packages the app may see are
+     * listed, so the blocklisted names belong in the manifest's queries.
+     */
+    private void refreshInstalledPackages() {
         try {
-            process = Runtime.getRuntime().exec(new String[]{"which", "su"});
-            BufferedReader reader = new BufferedReader(new FileReader(process.getInputStream().toString()));
-            return reader.readLine() != null;
-        } catch (Exception ignored) {
-            // Exception doesn't mean device is not rooted
-        } finally {
-            if (process != null) {
-                process.destroy();
+            List<PackageInfo> packages = context.getPackageManager().getInstalledPackages(0);
+            String[] names = new String[packages.size()];
+            for (int i = 0; i < names.length; i++) {
+                names[i] = packages.get(i).packageName;
             }
+            nativeCheckPackages(names);
+        } catch (RuntimeException e) {
+            // Binder failures: compare again on the next check
+            Log.e(TAG, "Error listing installed packages", e);
+            nativeNotifyPackagesChanged();
         }
-        
-        return false;
     }
     
     /**
@@ -652,15 +1029,18 @@ public class GameGuardianShield {
     }
     
     /**
-     * Generic protected value wrapper class
+     * Generic protected value wrapper class. Every operation is atomic, so
+     * one value may be shared by game, physics and network threads.
      */
     public static class ProtectedValue<T> {
+        private final GameGuardianShield shield;
         private final long nativePtr;
         private final T originalValue;
-        private boolean isValid = true;
+        private volatile boolean isValid = true;
         
         @SuppressWarnings("unchecked")
-        private ProtectedValue(long ptr, T initialValue) {
+        private ProtectedValue(GameGuardianShield shield, long ptr, T initialValue) {
+            this.shield = shield;
             this.nativePtr = ptr;
             this.originalValue = initialValue;
         }
@@ -673,23 +1053,23 @@ public class GameGuardianShield {
             
             // For Integer type
             if (originalValue instanceof Integer) {
-                return (T) Integer.valueOf(nativeGetInt(nativePtr));
+                return (T) Integer.valueOf(shield.nativeGetInt(nativePtr));
             } 
             // For Long type
             else if (originalValue instanceof Long) {
-                return (T) Long.valueOf(nativeGetLong(nativePtr));
+                return (T) Long.valueOf(shield.nativeGetLong(nativePtr));
             }
             // For Float type
             else if (originalValue instanceof Float) {
-                return (T) Float.valueOf(nativeGetFloat(nativePtr));
+                return (T) Float.valueOf(shield.nativeGetFloat(nativePtr));
             }
             // For Double type
             else if (originalValue instanceof Double) {
-                return (T) Double.valueOf(nativeGetDouble(nativePtr));
+                return (T) Double.valueOf(shield.nativeGetDouble(nativePtr));
             }
             // For Boolean type
             else if (originalValue instanceof Boolean) {
-                return (T) Boolean.valueOf(nativeGetBoolean(nativePtr));
+                return (T) Boolean.valueOf(shield.nativeGetBoolean(nativePtr));
             }
             
             return originalValue;
@@ -702,24 +1082,113 @@ public class GameGuardianShield {
             
             // For Integer type
             if (value instanceof Integer) {
-                nativeSetInt(nativePtr, (Integer) value);
+                shield.nativeSetInt(nativePtr, (Integer) value);
             }
             // For Long type
             else if (value instanceof Long) {
-                nativeSetLong(nativePtr, (Long) value);
+                shield.nativeSetLong(nativePtr, (Long) value);
             }
             // For Float type
             else if (value instanceof Float) {
-                nativeSetFloat(nativePtr, (Float) value);
+                shield.nativeSetFloat(nativePtr, (Float) value);
             }
             // For Double type
             else if (value instanceof Double) {
-                nativeSetDouble(nativePtr, (Double) value);
+                shield.nativeSetDouble(nativePtr, (Double) value);
             }
             // For Boolean type
             else if (value instanceof Boolean) {
-                nativeSetBoolean(nativePtr, (Boolean) value);
+                shield.nativeSetBoolean(nativePtr, (Boolean) value);
+            }
+        }
+        
+        /**
+         * Atomically add to an Integer, Long, Float or Double value and
+         * return the result. Integers wrap like Java arithmetic.
+         */
+        @SuppressWarnings("unchecked")
+        public T addAndGet(T delta) {
+            if (!isValid) {
+                return originalValue;
+            }
+            
+            if (delta instanceof Integer) {
+                return (T) Integer.valueOf(shield.nativeAddInt(nativePtr, (Integer) delta));
+            } else if (delta instanceof Long) {
+                return (T) Long.valueOf(shield.nativeAddLong(nativePtr, (Long) delta));
+            } else if (delta instanceof Float) {
+                return (T) Float.valueOf(shield.nativeAddFloat(nativePtr, (Float) delta));
+            } else if (delta instanceof Double) {
+                return (T) Double.valueOf(shield.nativeAddDouble(nativePtr, (Double) delta));
+            }
+            
+            throw new UnsupportedOperationException("addAndGet on a non-numeric value");
+        }
+        
+        /**
+         * Atomically add to an Integer or Long value, clamping the result
+         * into [min, max] instead of wrapping, and return the result.
+         */
+        @SuppressWarnings("unchecked")
+        public T clampAdd(T delta, T min, T max) {
+            if (!isValid) {
+                return originalValue;
+            }
+            
+            if (delta instanceof Integer) {
+                return (T) Integer.valueOf(shield.nativeClampAddInt(nativePtr,
+                        (Integer) delta, (Integer) min, (Integer) max));
+            } else if (delta instanceof Long) {
+                return (T) Long.valueOf(shield.nativeClampAddLong(nativePtr,
+                        (Long) delta, (Long) min, (Long) max));
+            }
+            
+            throw new UnsupportedOperationException("clampAdd on a non-integer value");
+        }
+        
+        /**
+         * Atomically add to an Integer or Long value only if the result
+         * stays within [min, max], e.g. {@code tryAdd(-price, 0L, Long.MAX_VALUE)}
+         * to spend currency. Returns false and leaves the value unchanged
+         * otherwise.
+         */
+        public boolean tryAdd(T delta, T min, T max) {
+            if (!isValid) {
+                return false;
+            }
+            
+            if (delta instanceof Integer) {
+                return shield.nativeTryAddInt(nativePtr, (Integer) delta, (Integer) min, (Integer) max);
+            } else if (delta instanceof Long) {
+                return shield.nativeTryAddLong(nativePtr, (Long) delta, (Long) min, (Long) max);
             }
+            
+            throw new UnsupportedOperationException("tryAdd on a non-integer value");
+        }
+        
+        /**
+         * Atomically set the value to {@code desired} if it currently equals
+         * {@code expected}. Floats and doubles are compared bit for bit, as
+         * by {@link Float#floatToRawIntBits}.
+         */
+        public boolean compareAndSet(T expected, T desired) {
+            if (!isValid) {
+                return false;
+            }
+            
+            if (expected instanceof Integer) {
+                return shield.nativeCompareAndSetInt(nativePtr, (Integer) expected, (Integer) desired);
+            } else if (expected instanceof Long) {
+                return shield.nativeCompareAndSetLong(nativePtr, (Long) expected, (Long) desired);
+            } else if (expected instanceof Float) {
+                return shield.nativeCompareAndSetFloat(nativePtr, (Float) expected, (Float) desired);
+            } else if (expected instanceof Double) {
+                return shield.nativeCompareAndSetDouble(nativePtr, (Double) expected, (Double) desired);
+            } else if (expected instanceof Boolean) {
+                return shield.nativeCompareAndSetBoolean(nativePtr, (Boolean) expected, (Boolean) desired);
+            }
+            
+            return false;
         }
         
         public void reset() {
@@ -736,7 +1205,7 @@ public class GameGuardianShield {
      */
     public ProtectedValue<Integer> protectInt(int initialValue) {
         long ptr = nativeProtectInt(initialValue);
-        ProtectedValue<Integer> value = new ProtectedValue<>(ptr, initialValue);
+        ProtectedValue<Integer> value = new ProtectedValue<>(this, ptr, initialValue);
         protectedValues.put("int:" + ptr, value);
         return value;
     }
@@ -746,7 +1215,19 @@ public class GameGuardianShield {
      */
     public ProtectedValue<Long> protectLong(long initialValue) {
         long ptr = nativeProtectLong(initialValue);
-        ProtectedValue<Long> value = new ProtectedValue<>(ptr, initialValue);
+        ProtectedValue<Long> value = new ProtectedValue<>(this, ptr, initialValue);
+        protectedValues.put("long:" + ptr, value);
+        return value;
+    }
+    
+    /**
+     * Create a protected long value kept in three independently masked
+     * copies. Reads return the majority and repair a copy that was edited;
+     * the edit is reported by the next value check.
+     */
+    public ProtectedValue<Long> protectRedundantLong(long initialValue) {
+        long ptr = nativeProtectRedundantLong(initialValue);
+        ProtectedValue<Long> value = new ProtectedValue<>(this, ptr, initialValue);
         protectedValues.put("long:" + ptr, value);
         return value;
     }
@@ -756,7 +1237,7 @@ public class GameGuardianShield {
      */
     public ProtectedValue<Float> protectFloat(float initialValue) {
         long ptr = nativeProtectFloat(initialValue);
-        ProtectedValue<Float> value = new ProtectedValue<>(ptr, initialValue);
+        ProtectedValue<Float> value = new ProtectedValue<>(this, ptr, initialValue);
         protectedValues.put("float:" + ptr, value);
         return value;
     }
@@ -766,7 +1247,7 @@ public class GameGuardianShield {
      */
     public ProtectedValue<Double> protectDouble(double initialValue) {
         long ptr = nativeProtectDouble(initialValue);
-        ProtectedValue<Double> value = new ProtectedValue<>(ptr, initialValue);
+        ProtectedValue<Double> value = new ProtectedValue<>(this, ptr, initialValue);
         protectedValues.put("double:" + ptr, value);
         return value;
     }
@@ -776,17 +1257,222 @@ public class GameGuardianShield {
      */
     public ProtectedValue<Boolean> protectBoolean(boolean initialValue) {
         long ptr = nativeProtectBoolean(initialValue);
-        ProtectedValue<Boolean> value = new ProtectedValue<>(ptr, initialValue);
+        ProtectedValue<Boolean> value = new ProtectedValue<>(this, ptr, initialValue);
         protectedValues.put("boolean:" + ptr, value);
         return value;
     }
     
     /**
      * Add a memory region to protection
+     * @return handle for beginRegionWrite/endRegionWrite
      */
-    public void protectMemoryRegion(long address, int size) {
-        nativeProtectMemoryRegion(address, size);
+    public long protectMemoryRegion(long address, int size) {
+        long handle = nativeProtectMemoryRegion(address, size);
         memoryRegions.add(address + ":" + size);
+        return handle;
+    }
+    
+    /**
+     * Start a batch of registrations. The native baseline table is unsealed
+     * once for the whole batch instead of once per call. Region writes need
+     * no batch: they never unseal the table.
+     * Every call must be matched by endProtectionBatch.
+     */
+    public void beginProtectionBatch() {
+        nativeBeginProtectionBatch();
+    }
+    
+    /**
+     * End a batch started with beginProtectionBatch and reseal the baselines
+     */
+    public void endProtectionBatch() {
+        nativeEndProtectionBatch();
+    }
+    
+    /**
+     * Announce a legitimate write to part of a protected region.
+     * Must be paired with endRegionWrite once the bytes are written.
+     * @param handle handle returned by protectMemoryRegion
+     * @param offset offset of the write within the region
+     * @param size number of bytes written
+     * @return false if the range lies outside the region, overlaps a write
+     *         this thread has open, or was modified outside a write
+     */
+    public boolean beginRegionWrite(long handle, int offset, int size) {
+        return nativeBeginRegionWrite(handle, offset, size);
+    }
+    
+    /**
+     * Finish a write started with beginRegionWrite and update the region
+     * baseline. Must be called on the thread that began the write, with the
+     * same range; a write left open is reported as tampering. Costs a
+     * re-hash of the written 4 KiB leaves and no system call; the new
+     * baseline is sealed by the next integrity check.
+     * @return false if this thread has no such write open
+     */
+    public boolean endRegionWrite(long handle, int offset, int size) {
+        return nativeEndRegionWrite(handle, offset, size);
+    }
+    
+    /**
+     * Allocate a zeroed native block for a whole struct (inventory, stat
+     * block) that is verified with the protected memory regions
+     * @return handle for the bulk byte methods and beginRegionWrite/endRegionWrite,
+     *         or 0 on failure
+     */
+    public long protectBytes(int size) {
+        return nativeProtectBytes(size);
+    }
+    
+    /**
+     * Direct view of a protected block. Reads are zero-copy; every write
+     * through the view must be bracketed by beginRegionWrite/endRegionWrite.
+     * The block is unmapped by destroy(), so drop the view before that.
+     */
+    public ByteBuffer protectedBytesView(long handle) {
+        return nativeGetBytesBuffer(handle);
+    }
+    
+    /**
+     * Fill out with the block's bytes starting at offset, checking them
+     * against the baseline first
+     * @return false if the bytes were tampered with or the range is invalid
+     */
+    public boolean readProtectedBytes(long handle, int offset, byte[] out) {
+        return nativeReadBytes(handle, offset, out);
+    }
+    
+    /**
+     * Write data into the block at offset and update its baseline in one call
+     */
+    public boolean writeProtectedBytes(long handle, int offset, byte[] data) {
+        return nativeWriteBytes(handle, offset, data);
+    }
+    
+    /**
+     * Create a vault for a large game-state blob. Its bytes are kept
+     * encrypted in memory and only the lines an access touches are decrypted.
+     * @return handle for vaultRead/vaultWrite, or 0 on failure
+     */
+    public long createVault(int size) {
+        return nativeCreateVault(size);
+    }
+    
+    /**
+     * Decrypt out.length bytes of a vault starting at offset into out
+     */
+    public boolean vaultRead(long handle, int offset, byte[] out) {
+        return nativeVaultRead(handle, offset, out);
+    }
+    
+    /**
+     * Encrypt data into a vault starting at offset
+     */
+    public boolean vaultWrite(long handle, int offset, byte[] data) {
+        return nativeVaultWrite(handle, offset, data);
+    }
+    
+    /**
+     * Verify memory regions in a forked copy-on-write snapshot of the process
+     * instead of in place. Checks no longer wait on hashing or race game
+     * writes; each check reports the verdict of the snapshot taken by the
+     * previous one.
+     */
+    public void setSnapshotVerification(boolean enabled) {
+        nativeSetSnapshotVerification(enabled);
+    }
+    
+    /**
+     * Run memory and value checks and cheat tool detection on the efficiency
+     * cores of big.LITTLE devices at reduced priority, and attestation on the
+     * performance cores so it meets its deadline. Enabled by default.
+     */
+    public void setVerifierCpuPlacement(boolean enabled) {
+        nativeSetCpuPlacement(enabled);
+    }
+    
+    /**
+     * Time the calling thread spent forking the last verification snapshot
+     */
+    public long getSnapshotForkNanos() {
+        return nativeGetSnapshotForkNanos();
+    }
+    
+    /**
+     * Stall watchdog wake lateness counts in log2 millisecond buckets:
+     * [0,1), [1,2), [2,4) ... with the last bucket holding 8 s and more.
+     * Call stopProtection() while the game is backgrounded, since Android
+     * freezes cached apps and that would read as a stall.
+     */
+    public long[] getStallHistogram() {
+        return nativeGetStallHistogram();
+    }
+    
+    /**
+     * Count CPU events of every detector run for getDetectorStats(). Off by
+     * default; it costs a few syscalls per run. Hardware counters need a
+     * PMU and a device that lets apps use perf events (on release Android
+     * builds, setprop security.perf_harden 0).
+     */
+    public void setPerfCounters(boolean enabled) {
+        nativeSetPerfCounters(enabled);
+    }
+    
+    /**
+     * Totals over a detector's runs since startup, counted while
+     * setPerfCounters() was on: runs, wall time in ns, CPU cycles,
+     * instructions, cache misses, page faults and context switches.
+     * Counters the device could not open are -1.
+     * @param detector one of DETECTOR_*
+     */
+    public long[] getDetectorStats(int detector) {
+        return nativeGetDetectorStats(detector);
+    }
+    
+    /**
+     * Root evidence as ROOT_SIGNAL_* bits, 0 when none was found. The probes
+     * are syscalls only and run once; later calls return the cached result.
+     */
+    public int getRootSignals() {
+        return nativeGetRootSignals();
+    }
+    
+    /**
+     * Replace the paths probed for su binaries and root manager files
+     * @param paths absolute paths, or null for the built-in table
+     */
+    public void setRootProbePaths(String[] paths) {
+        nativeSetRootProbePaths(paths);
+    }
+    
+    /**
+     * Select how memory regions registered afterwards are verified
+     * @param mode INTEGRITY_MODE_KEYED (default) for a session-keyed tree hash,
+     *             INTEGRITY_MODE_CHECKSUM for the legacy unkeyed checksum
+     */
+    public void setIntegrityMode(int mode) {
+        nativeSetIntegrityMode(mode);
+    }
+    
+    /**
+     * Plant plaintext decoy copies of a protected value. Decoys follow every
+     * set() of the value, so a memory search for the current amount finds
+     * them; any edit to a decoy is reported as value tampering.
+     * @param value protected value to mirror
+     * @param copies number of decoys, spread over separate pages
+     * @return number of decoys planted
+     */
+    public int addDecoys(ProtectedValue<?> value, int copies) {
+        return nativeAddDecoys(value.nativePtr, copies);
+    }
+    
+    /**
+     * Set how long each integrity check may spend moving protected values to
+     * new native addresses, so editors can't pin an address once found.
+     * @param micros time budget per check in microseconds, 0 to disable
+     */
+    public void setValueRelocationBudget(int micros) {
+        nativeSetValueRelocationBudget(micros);
     }
     
     /**
@@ -808,9 +1494,9 @@ public class GameGuardianShield {
      */
     public void destroy() {
         stopProtection();
-        nativeDestroy();
         
-        // Shutdown executor
+        // Shutdown executor first so checks stop being queued; nativeDestroy
+        // waits for native calls still running on any thread
         try {
             executorService.shutdown();
             if (!executorService.awaitTermination(2, TimeUnit.SECONDS)) {
@@ -819,20 +1505,63 @@ public class GameGuardianShield {
         } catch (InterruptedException e) {
             executorService.shutdownNow();
         }
+        
+        nativeDestroy();
     }
     
     // Native method declarations
+    private native long nativeCreateContext();
     private native boolean initNativeProtection(Context context);
     private native boolean detectCheatTools();
-    private native void nativeProtectMemoryRegion(long address, int size);
+    private native boolean nativePackagesChanged();
+    private native void nativeNotifyPackagesChanged();
+    private native boolean nativeCheckPackages(String[] installed);
+    private native long nativeProtectMemoryRegion(long address, int size);
+    private native boolean nativeBeginRegionWrite(long handle, int offset, int size);
+    private native boolean nativeEndRegionWrite(long handle, int offset, int size);
+    private native long nativeProtectBytes(int size);
+    private native ByteBuffer nativeGetBytesBuffer(long handle);
+    private native boolean nativeReadBytes(long handle, int offset, byte[] out);
+    private native boolean nativeWriteBytes(long handle, int offset, byte[] data);
+    private native long nativeCreateVault(int size);
+    private native boolean nativeVaultRead(long handle, int offset, byte[] out);
+    private native boolean nativeVaultWrite(long handle, int offset, byte[] data);
+    private native void nativeBeginProtectionBatch();
+    private native void nativeEndProtectionBatch();
+    private native void nativeSetValueRelocationBudget(int micros);
+    private native void nativeSetJournalEnabled(boolean enabled);
+    private native void nativeSetJournalTag(int tag);
+    private native byte[] nativeDrainJournal();
+    private native int nativeAddDecoys(long ptr, int copies);
+    private native void nativeSetIntegrityMode(int mode);
+    private native void nativeSetSnapshotVerification(boolean enabled);
+    private native long nativeGetSnapshotForkNanos();
+    private native void nativeSetCpuPlacement(boolean enabled);
     private native boolean nativeCheckProtectedMemory();
     private native boolean nativeCheckProtectedValues();
+    private native byte[] nativeSha256Batch(byte[][] inputs);
+    private native boolean nativeAddAttestationRegion(long handle);
+    private native String nativeGetAbi();
+    private native byte[] nativeAttest(byte[] nonce, int deadlineMicros);
+    private native boolean nativeStartStallWatchdog(int periodMs, int thresholdMs);
+    private native void nativeStopStallWatchdog();
+    private native boolean nativeCheckProcessStalls();
+    private native long[] nativeGetStallHistogram();
+    private native void nativeSetPerfCounters(boolean enabled);
+    private native long[] nativeGetDetectorStats(int detector);
+    private native int nativeRegisterLiveness(int deadlineMs);
+    private native void nativeUnregisterLiveness(int slot);
+    private native void nativeLivenessBeat(int slot);
+    private native boolean nativeCheckLiveness(int self, int maxGapMs);
+    private native int nativeGetRootSignals();
+    private native void nativeSetRootProbePaths(String[] paths);
     private native void nativeApplyCountermeasures(int severity, String type);
     private native void nativeDestroy();
     
     // Protected value native methods
     private native long nativeProtectInt(int value);
     private native long nativeProtectLong(long value);
+    private native long nativeProtectRedundantLong(long value);
     private native long nativeProtectFloat(float value);
     private native long nativeProtectDouble(double value);
     private native long nativeProtectBoolean(boolean value);
@@ -848,4 +1577,19 @@ public class GameGuardianShield {
     private native void nativeSetFloat(long ptr, float value);
     private native void nativeSetDouble(long ptr, double value);
     private native void nativeSetBoolean(long ptr, boolean value);
+    
+    private native int nativeAddInt(long ptr, int delta);
+    private native long nativeAddLong(long ptr, long delta);
+    private native float nativeAddFloat(long ptr, float delta);
+    private native double nativeAddDouble(long ptr, double delta);
+    private native int nativeClampAddInt(long ptr, int delta, int min, int max);
+    private native long nativeClampAddLong(long ptr, long delta, long min, long max);
+    private native boolean nativeTryAddInt(long ptr, int delta, int min, int max);
+    private native boolean nativeTryAddLong(long ptr, long delta, long min, long max);
+    
+    private native boolean nativeCompareAndSetInt(long ptr, int expected, int desired);
+    private native boolean nativeCompareAndSetLong(long ptr, long expected, long desired);
+    private native boolean nativeCompareAndSetFloat(long ptr, float expected, float desired);
+    private native boolean nativeCompareAndSetDouble(long ptr, double expected, double desired);
+    private native boolean nativeCompareAndSetBoolean(long ptr, boolean expected, boolean desired);
 }
@@ -0,0 +1,39 @@
+#ifndef STFU_GAME_GUARDIAN_SHIELD_API_H
+#define STFU_GAME_GUARDIAN_SHIELD_API_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Native API for game code that links against the shield library.
+// Region handles are the values returned by GameGuardianShield.protectMemoryRegion()
+// or protectBytes(). Once the shield is destroyed its handles are dead and
+// every call with one returns false.
+
+#define STFU_API __attribute__((visibility("default")))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Call around every legitimate write to a protected region so the write is
+// folded into the region's baseline instead of being reported as tampering.
+// Begin returns false when the range is outside the region, overlaps a
+// write the calling thread already has open, or was modified since it was
+// last sealed. End must come from the thread that called begin, with the
+// same range; otherwise it returns false and changes nothing. A write left
+// open across several integrity checks is reported as tampering. End
+// re-hashes the written 4 KiB leaves and makes no system call.
+STFU_API bool stfuBeginRegionWrite(int64_t handle, size_t offset, size_t size);
+STFU_API bool stfuEndRegionWrite(int64_t handle, size_t offset, size_t size);
+
+// Plaintext access to a vault from GameGuardianShield.createVault(). Only the
+// 64-byte lines touched are decrypted; nothing is decrypted in place.
+// Both return false when the range is outside the vault.
+STFU_API bool stfuVaultRead(int64_t handle, size_t offset, void* out, size_t size);
+STFU_API bool stfuVaultWrite(int64_t handle, size_t offset, const void* data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STFU_GAME_GUARDIAN_SHIELD_API_H
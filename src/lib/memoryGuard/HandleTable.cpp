@@ -0,0 +1,128 @@
+#include "HandleTable.h"
+
+#include <sched.h>
+
+#include <mutex>
+#include <vector>
+
+constexpr size_t kSlotsPerChunk = 256;
+constexpr size_t kMaxChunks = 256;
+
+struct HandleSlot {
+    std::atomic<uint32_t> generation{1};
+    std::atomic<uint32_t> users{0};
+    HandleKind kind = HANDLE_REGION;
+    void* object = nullptr;
+    void* owner = nullptr; // Null while the slot is free
+};
+
+struct HandleTable {
+    std::mutex mutex; // Guards creation, retirement and the free list
+    std::atomic<HandleSlot*> chunks[kMaxChunks] = {};
+    size_t slotCount = 0;
+    std::vector<uint32_t> freeSlots;
+};
+
+// Never destroyed: handles may be used from threads still running at exit
+static HandleTable& handleTable() {
+    static HandleTable* table = new HandleTable();
+    return *table;
+}
+
+static HandleSlot* slotAt(HandleTable& table, size_t index) {
+    if (index >= kSlotsPerChunk * kMaxChunks) return nullptr;
+    HandleSlot* chunk = table.chunks[index / kSlotsPerChunk].load(std::memory_order_acquire);
+    return chunk ? &chunk[index % kSlotsPerChunk] : nullptr;
+}
+
+// Handles are (generation << 32) | (index + 1), so 0 is never a handle
+static int64_t makeHandle(uint32_t generation, size_t index) {
+    return static_cast<int64_t>((static_cast<uint64_t>(generation) << 32) | (index + 1));
+}
+
+int64_t handleCreate(HandleKind kind, void* object, void* owner) {
+    HandleTable& table = handleTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+
+    size_t index;
+    if (!table.freeSlots.empty()) {
+        index = table.freeSlots.back();
+        table.freeSlots.pop_back();
+    } else {
+        index = table.slotCount;
+        if (index >= kSlotsPerChunk * kMaxChunks) return 0;
+        if (index % kSlotsPerChunk == 0) {
+            table.chunks[index / kSlotsPerChunk].store(new HandleSlot[kSlotsPerChunk],
+                                                       std::memory_order_release);
+        }
+        table.slotCount++;
+    }
+
+    HandleSlot* slot = slotAt(table, index);
+    slot->kind = kind;
+    slot->object = object;
+    slot->owner = owner;
+    // Publishes the fields above to resolvers that see the new generation
+    uint32_t generation = slot->generation.fetch_add(1) + 1;
+    return makeHandle(generation, index);
+}
+
+// Called with the table mutex held
+static void retireSlot(HandleTable& table, HandleSlot* slot, size_t index) {
+    slot->generation.fetch_add(1);
+    while (slot->users.load() != 0) {
+        sched_yield();
+    }
+    slot->object = nullptr;
+    slot->owner = nullptr;
+    table.freeSlots.push_back(static_cast<uint32_t>(index));
+}
+
+bool handleRetire(int64_t handle) {
+    HandleTable& table = handleTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+
+    uint64_t bits = static_cast<uint64_t>(handle);
+    size_t index = static_cast<size_t>(bits & 0xffffffff) - 1;
+    HandleSlot* slot = slotAt(table, index);
+    if (!slot || !slot->owner || slot->generation.load() != static_cast<uint32_t>(bits >> 32)) {
+        return false;
+    }
+    retireSlot(table, slot, index);
+    return true;
+}
+
+void handleRetireOwner(void* owner) {
+    HandleTable& table = handleTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+
+    for (size_t index = 0; index < table.slotCount; index++) {
+        HandleSlot* slot = slotAt(table, index);
+        if (slot->owner == owner) {
+            retireSlot(table, slot, index);
+        }
+    }
+}
+
+HandleRef::HandleRef(int64_t handle, HandleKind kind) {
+    uint64_t bits = static_cast<uint64_t>(handle);
+    size_t index = static_cast<size_t>(bits & 0xffffffff);
+    if (index == 0) return;
+
+    HandleSlot* slot = slotAt(handleTable(), index - 1);
+    if (!slot) return;
+
+    // Count ourselves first so a retirer that bumps the generation after
+    // our check waits for us (both sides are sequentially consistent)
+    slot->users.fetch_add(1);
+    users = &slot->users;
+    if (slot->generation.load() != static_cast<uint32_t>(bits >> 32) || slot->kind != kind) {
+        return;
+    }
+    object = slot->object;
+    owner = slot->owner;
+}
+
+HandleRef::~HandleRef() {
+    if (users) users->fetch_sub(1, std::memory_order_release);
+}
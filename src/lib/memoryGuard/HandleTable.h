@@ -0,0 +1,56 @@
+#ifndef STFU_HANDLE_TABLE_H
+#define STFU_HANDLE_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Handles given out for native contexts, protected regions and vaults.
+//
+// A handle is a slot number in a process-wide table tagged with the slot's
+// generation, not a pointer: game code keeps handles after destroy(), the
+// native write API gets nothing but the handle, and a JNI call may still be
+// running when another thread destroys its context. Retiring a handle bumps
+// its slot's generation, so a stale handle or one from another instance
+// fails to resolve instead of reaching freed memory.
+//
+// Resolving is lock-free, because region writes sit on the game's hot
+// path: a HandleRef counts itself as a user of the slot, then rechecks the
+// generation. Retiring bumps the generation first and then waits for the
+// slot's users to finish, so nothing a caller can still reach is freed.
+// Callers must not block on work that needs another handle of the same
+// owner while they hold a HandleRef.
+//
+// Slots live in chunks that are allocated once and never freed, so a slot
+// address stays valid whatever happens to the handle.
+
+enum HandleKind : uint8_t {
+    HANDLE_REGION = 1,  // ShieldRegion
+    HANDLE_VAULT = 2,   // Vault
+    HANDLE_CONTEXT = 3, // ShieldContext, owned by itself
+};
+
+// New handle for `object`, owned by `owner` (its ShieldContext); 0 when
+// the table is full
+int64_t handleCreate(HandleKind kind, void* object, void* owner);
+
+// Retire one handle, waiting for its users. False if it was not live, so
+// of several callers racing to retire a handle exactly one gets true.
+bool handleRetire(int64_t handle);
+
+// Retire every handle of `owner`, waiting for their users
+void handleRetireOwner(void* owner);
+
+// Scoped use of a handle; object is null if it is not live or not `kind`
+struct HandleRef {
+    HandleRef(int64_t handle, HandleKind kind);
+    ~HandleRef();
+    HandleRef(const HandleRef&) = delete;
+    HandleRef& operator=(const HandleRef&) = delete;
+
+    void* object = nullptr;
+    void* owner = nullptr;
+    std::atomic<uint32_t>* users = nullptr;
+};
+
+#endif // STFU_HANDLE_TABLE_H
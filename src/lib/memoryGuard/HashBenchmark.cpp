@@ -0,0 +1,108 @@
+// Throughput of the region integrity hashes: the keyed tree hash, zlib's
+// CRC32 and the djb2 checksum. Built when STFU_BUILD_BENCHMARKS is on; run
+// on a device with
+//
+//   adb push stfu_hash_benchmark /data/local/tmp
+//   adb shell /data/local/tmp/stfu_hash_benchmark
+//
+// Each hash is timed over an L2-sized buffer (256 KiB, the verifier's scan
+// chunk) and a 16 MiB one, on one thread; the tree hash is also timed the
+// way regions above 256 KiB are sealed, split across worker threads. On one
+// thread the tree hash goes leaf by leaf, as a verifier worker does.
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+#include <thread>
+#include <vector>
+
+#include "KeyedTreeHash.h"
+#include "RegionGuard.h"
+
+// Each measurement runs for at least this long and keeps its best pass
+constexpr double kMinSeconds = 0.5;
+constexpr int kPasses = 5;
+
+static volatile uint32_t g_sink;
+
+template <typename F>
+static double bytesPerSecond(size_t bytes, F hash) {
+    using Clock = std::chrono::steady_clock;
+    hash(); // Warm up caches and page tables
+
+    double best = 0;
+    for (int pass = 0; pass < kPasses; pass++) {
+        size_t iterations = 0;
+        Clock::time_point start = Clock::now();
+        double elapsed;
+        do {
+            hash();
+            iterations++;
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        } while (elapsed < kMinSeconds / kPasses);
+        best = std::max(best, static_cast<double>(bytes) * iterations / elapsed);
+    }
+    return best;
+}
+
+static void report(const char* name, size_t bytes, double rate) {
+    printf("%-22s %8zu KiB %8.2f GB/s\n", name, bytes >> 10, rate / 1e9);
+}
+
+static void benchmark(size_t bytes, unsigned threads) {
+    // Page-aligned like a protected block, so every leaf is full
+    void* block = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (block == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+    uint8_t* data = static_cast<uint8_t*>(block);
+    for (size_t i = 0; i < bytes; i++) {
+        data[i] = static_cast<uint8_t>(rand());
+    }
+
+    TreeHashKey key;
+    for (uint32_t& word : key.words) {
+        word = static_cast<uint32_t>(rand());
+    }
+    std::vector<TreeDigest> leaves(treeLeafCount(data, bytes));
+
+    report("tree hash", bytes, bytesPerSecond(bytes, [&] {
+        g_sink = treeHashRegion(key, data, bytes, leaves.data(), 1).words[0];
+    }));
+    if (threads > 1) {
+        char name[32];
+        snprintf(name, sizeof(name), "tree hash x%u", threads);
+        report(name, bytes, bytesPerSecond(bytes, [&] {
+            g_sink = treeHashRegion(key, data, bytes, leaves.data(), threads).words[0];
+        }));
+    }
+    report("crc32 (zlib)", bytes, bytesPerSecond(bytes, [&] {
+        g_sink = static_cast<uint32_t>(crc32(0, data, static_cast<uInt>(bytes)));
+    }));
+    report("djb2", bytes, bytesPerSecond(bytes, [&] {
+        g_sink = calculateChecksum(data, bytes);
+    }));
+
+    munmap(block, bytes);
+}
+
+int main() {
+    // Same cap as kMaxHashThreads in GameGuardianShield.cpp
+    unsigned threads = std::min(4u, std::max(1u, std::thread::hardware_concurrency()));
+
+#if defined(__aarch64__)
+    printf("arm64, %u CPUs\n", std::thread::hardware_concurrency());
+#elif defined(__x86_64__)
+    printf("x86-64, %u CPUs\n", std::thread::hardware_concurrency());
+#endif
+    benchmark(256 << 10, 1);
+    benchmark(16 << 20, threads);
+    return 0;
+}
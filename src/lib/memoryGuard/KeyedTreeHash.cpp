@@ -0,0 +1,369 @@
+#include "KeyedTreeHash.h"
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "ParallelFor.h"
+
+// Compression function and flags follow BLAKE3 (7 rounds, keyed mode)
+static const uint32_t IV[8] = {
+    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+    0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19,
+};
+
+static constexpr uint8_t MSG_SCHEDULE[7][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8},
+    {3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1},
+    {10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6},
+    {12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4},
+    {9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7},
+    {11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13},
+};
+
+enum TreeFlags : uint32_t {
+    CHUNK_START = 1 << 0,
+    CHUNK_END = 1 << 1,
+    PARENT = 1 << 2,
+    ROOT = 1 << 3,
+    KEYED_HASH = 1 << 4,
+};
+
+constexpr size_t kBlockSize = 64;
+constexpr size_t kChunksPerLeaf = kTreeLeafSize / kTreeChunkSize;
+constexpr size_t kBlocksPerChunk = kTreeChunkSize / kBlockSize;
+
+// Leaves per worker below which threading costs more than it saves
+constexpr size_t kLeavesPerWorker = 64;
+
+// Four 32-bit lanes; lowers to NEON on arm64 and SSE2 on x86
+typedef uint32_t TreeLanes __attribute__((vector_size(16)));
+typedef uint8_t TreeBytes __attribute__((vector_size(16)));
+
+template <int N>
+static inline TreeLanes rotr(TreeLanes x) {
+    return (x >> N) | (x << (32 - N));
+}
+
+// Rotations by whole bytes are one byte shuffle per vector (REV32 or TBL
+// on arm64, PSHUFB on x86) instead of two shifts and an OR
+#if defined(__aarch64__) || defined(__SSSE3__)
+template <>
+inline TreeLanes rotr<16>(TreeLanes x) {
+    TreeBytes b = reinterpret_cast<TreeBytes>(x);
+    return reinterpret_cast<TreeLanes>(__builtin_shufflevector(
+            b, b, 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13));
+}
+
+template <>
+inline TreeLanes rotr<8>(TreeLanes x) {
+    TreeBytes b = reinterpret_cast<TreeBytes>(x);
+    return reinterpret_cast<TreeLanes>(__builtin_shufflevector(
+            b, b, 1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12));
+}
+#endif
+
+// NEON has no vector rotate, and shift-or lowers to three instructions;
+// shift right and insert the rest with SLI in two
+#if defined(__aarch64__)
+template <>
+inline TreeLanes rotr<12>(TreeLanes x) {
+    uint32x4_t u = reinterpret_cast<uint32x4_t>(x);
+    return reinterpret_cast<TreeLanes>(vsliq_n_u32(vshrq_n_u32(u, 12), u, 20));
+}
+
+template <>
+inline TreeLanes rotr<7>(TreeLanes x) {
+    uint32x4_t u = reinterpret_cast<uint32x4_t>(x);
+    return reinterpret_cast<TreeLanes>(vsliq_n_u32(vshrq_n_u32(u, 7), u, 25));
+}
+#endif
+
+// The message word is added first so that only the add of the freshly
+// mixed v[b] sits on the dependency chain
+static inline void mix(TreeLanes* v, int a, int b, int c, int d, TreeLanes mx, TreeLanes my) {
+    v[a] = v[a] + mx + v[b];
+    v[d] = rotr<16>(v[d] ^ v[a]);
+    v[c] = v[c] + v[d];
+    v[b] = rotr<12>(v[b] ^ v[c]);
+    v[a] = v[a] + my + v[b];
+    v[d] = rotr<8>(v[d] ^ v[a]);
+    v[c] = v[c] + v[d];
+    v[b] = rotr<7>(v[b] ^ v[c]);
+}
+
+// One round of four independent compressions, one per lane. Rounds are
+// instantiated one by one so message words are picked at compile time.
+template <int R>
+static inline void laneRound(TreeLanes* v, const TreeLanes* m) {
+    constexpr const uint8_t* s = MSG_SCHEDULE[R];
+    mix(v, 0, 4, 8, 12, m[s[0]], m[s[1]]);
+    mix(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+    mix(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);
+    mix(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+    mix(v, 0, 5, 10, 15, m[s[8]], m[s[9]]);
+    mix(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+    mix(v, 2, 7, 8, 13, m[s[12]], m[s[13]]);
+    mix(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+}
+
+// One round of a single compression whose 16 state words are held as four
+// rows. The columns mix lane-wise; rotating rows 1-3 lines the diagonals
+// up in lanes for the second half, and rotating back restores the rows.
+template <int R>
+static inline void rowRound(TreeLanes* rows, const uint32_t* m) {
+    constexpr const uint8_t* s = MSG_SCHEDULE[R];
+    mix(rows, 0, 1, 2, 3,
+        TreeLanes{m[s[0]], m[s[2]], m[s[4]], m[s[6]]},
+        TreeLanes{m[s[1]], m[s[3]], m[s[5]], m[s[7]]});
+    rows[1] = __builtin_shufflevector(rows[1], rows[1], 1, 2, 3, 0);
+    rows[2] = __builtin_shufflevector(rows[2], rows[2], 2, 3, 0, 1);
+    rows[3] = __builtin_shufflevector(rows[3], rows[3], 3, 0, 1, 2);
+    mix(rows, 0, 1, 2, 3,
+        TreeLanes{m[s[8]], m[s[10]], m[s[12]], m[s[14]]},
+        TreeLanes{m[s[9]], m[s[11]], m[s[13]], m[s[15]]});
+    rows[1] = __builtin_shufflevector(rows[1], rows[1], 3, 0, 1, 2);
+    rows[2] = __builtin_shufflevector(rows[2], rows[2], 2, 3, 0, 1);
+    rows[3] = __builtin_shufflevector(rows[3], rows[3], 1, 2, 3, 0);
+}
+
+static inline TreeLanes broadcast(uint32_t x) {
+    return TreeLanes{x, x, x, x};
+}
+
+// Single-block compression, chaining value updated in place. Used for
+// parent nodes and partial chunks, so every full leaf pays for three; the
+// row layout keeps each to about a third of the instructions of a
+// four-lane compression.
+static void compress(uint32_t cv[8], const uint8_t block[kBlockSize],
+                     uint32_t blockLen, uint64_t counter, uint32_t flags) {
+    uint32_t m[16];
+    memcpy(m, block, kBlockSize);
+
+    TreeLanes rows[4];
+    memcpy(&rows[0], cv, 16);
+    memcpy(&rows[1], cv + 4, 16);
+    rows[2] = TreeLanes{IV[0], IV[1], IV[2], IV[3]};
+    rows[3] = TreeLanes{static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32),
+                        blockLen, flags};
+
+    rowRound<0>(rows, m);
+    rowRound<1>(rows, m);
+    rowRound<2>(rows, m);
+    rowRound<3>(rows, m);
+    rowRound<4>(rows, m);
+    rowRound<5>(rows, m);
+    rowRound<6>(rows, m);
+
+    rows[0] ^= rows[2];
+    rows[1] ^= rows[3];
+    memcpy(cv, &rows[0], 16);
+    memcpy(cv + 4, &rows[1], 16);
+}
+
+static void hashChunk(const TreeHashKey& key, const uint8_t* data, size_t len,
+                      uint64_t counter, uint32_t cv[8]) {
+    memcpy(cv, key.words, sizeof(key.words));
+
+    size_t blocks = len == 0 ? 1 : (len + kBlockSize - 1) / kBlockSize;
+    for (size_t b = 0; b < blocks; b++) {
+        size_t offset = b * kBlockSize;
+        size_t blockLen = std::min(kBlockSize, len - offset);
+
+        uint8_t block[kBlockSize] = {0};
+        memcpy(block, data + offset, blockLen);
+
+        uint32_t flags = KEYED_HASH;
+        if (b == 0) flags |= CHUNK_START;
+        if (b == blocks - 1) flags |= CHUNK_END;
+        compress(cv, block, static_cast<uint32_t>(blockLen), counter, flags);
+    }
+}
+
+// Hash the four chunks of a full leaf in parallel lanes
+static void hashChunksX4(const TreeHashKey& key, const uint8_t* data,
+                         uint64_t counter, TreeDigest cvs[4]) {
+    TreeLanes h[8];
+    for (int i = 0; i < 8; i++) {
+        h[i] = broadcast(key.words[i]);
+    }
+
+    const TreeLanes counterLo = {
+        static_cast<uint32_t>(counter), static_cast<uint32_t>(counter + 1),
+        static_cast<uint32_t>(counter + 2), static_cast<uint32_t>(counter + 3),
+    };
+    const TreeLanes counterHi = broadcast(static_cast<uint32_t>(counter >> 32));
+
+    for (size_t b = 0; b < kBlocksPerChunk; b++) {
+        const uint8_t* p = data + b * kBlockSize;
+
+        // Transpose 4x4 word tiles so lane j holds chunk j's message words
+        TreeLanes m[16];
+        for (int q = 0; q < 4; q++) {
+            TreeLanes r0, r1, r2, r3;
+            memcpy(&r0, p + 0 * kTreeChunkSize + 16 * q, 16);
+            memcpy(&r1, p + 1 * kTreeChunkSize + 16 * q, 16);
+            memcpy(&r2, p + 2 * kTreeChunkSize + 16 * q, 16);
+            memcpy(&r3, p + 3 * kTreeChunkSize + 16 * q, 16);
+
+            TreeLanes lo01 = __builtin_shufflevector(r0, r1, 0, 4, 1, 5);
+            TreeLanes hi01 = __builtin_shufflevector(r0, r1, 2, 6, 3, 7);
+            TreeLanes lo23 = __builtin_shufflevector(r2, r3, 0, 4, 1, 5);
+            TreeLanes hi23 = __builtin_shufflevector(r2, r3, 2, 6, 3, 7);
+
+            m[4 * q + 0] = __builtin_shufflevector(lo01, lo23, 0, 1, 4, 5);
+            m[4 * q + 1] = __builtin_shufflevector(lo01, lo23, 2, 3, 6, 7);
+            m[4 * q + 2] = __builtin_shufflevector(hi01, hi23, 0, 1, 4, 5);
+            m[4 * q + 3] = __builtin_shufflevector(hi01, hi23, 2, 3, 6, 7);
+        }
+
+        uint32_t flags = KEYED_HASH;
+        if (b == 0) flags |= CHUNK_START;
+        if (b == kBlocksPerChunk - 1) flags |= CHUNK_END;
+
+        TreeLanes v[16] = {
+            h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+            broadcast(IV[0]), broadcast(IV[1]), broadcast(IV[2]), broadcast(IV[3]),
+            counterLo, counterHi, broadcast(kBlockSize), broadcast(flags),
+        };
+        laneRound<0>(v, m);
+        laneRound<1>(v, m);
+        laneRound<2>(v, m);
+        laneRound<3>(v, m);
+        laneRound<4>(v, m);
+        laneRound<5>(v, m);
+        laneRound<6>(v, m);
+
+        for (int i = 0; i < 8; i++) {
+            h[i] = v[i] ^ v[i + 8];
+        }
+    }
+
+    for (int lane = 0; lane < 4; lane++) {
+        for (int i = 0; i < 8; i++) {
+            cvs[lane].words[i] = h[i][lane];
+        }
+    }
+}
+
+static void parentCv(const TreeHashKey& key, const uint32_t left[8],
+                     const uint32_t right[8], uint32_t out[8]) {
+    uint8_t block[kBlockSize];
+    memcpy(block, left, 32);
+    memcpy(block + 32, right, 32);
+
+    memcpy(out, key.words, sizeof(key.words));
+    compress(out, block, kBlockSize, 0, PARENT | KEYED_HASH);
+}
+
+// Merge n chaining values in place; left subtree is the largest power of two
+static void mergeCvs(const TreeHashKey& key, TreeDigest* cvs, size_t n) {
+    if (n <= 1) return;
+
+    size_t left = 1;
+    while (left * 2 < n) left *= 2;
+
+    mergeCvs(key, cvs, left);
+    mergeCvs(key, cvs + left, n - left);
+    parentCv(key, cvs[0].words, cvs[left].words, cvs[0].words);
+}
+
+size_t treeLeafCount(const void* addr, size_t size) {
+    if (!addr || size == 0) return 0;
+
+    uintptr_t start = reinterpret_cast<uintptr_t>(addr);
+    uintptr_t first = start / kTreeLeafSize;
+    uintptr_t last = (start + size - 1) / kTreeLeafSize;
+    return static_cast<size_t>(last - first + 1);
+}
+
+void treeLeafBounds(const void* addr, size_t size, size_t leaf,
+                    const uint8_t** leafData, size_t* leafLen) {
+    uintptr_t start = reinterpret_cast<uintptr_t>(addr);
+    uintptr_t end = start + size;
+    uintptr_t leafStart = (start / kTreeLeafSize + leaf) * kTreeLeafSize;
+
+    uintptr_t from = std::max(start, leafStart);
+    uintptr_t to = std::min(end, leafStart + kTreeLeafSize);
+
+    *leafData = reinterpret_cast<const uint8_t*>(from);
+    *leafLen = static_cast<size_t>(to - from);
+}
+
+TreeDigest treeHashLeaf(const TreeHashKey& key, const uint8_t* data, size_t len) {
+    uintptr_t addr = reinterpret_cast<uintptr_t>(data);
+    uint64_t counter = static_cast<uint64_t>(addr / kTreeLeafSize) * kChunksPerLeaf;
+
+    TreeDigest cvs[kChunksPerLeaf];
+    size_t chunks;
+
+    if (len == kTreeLeafSize) {
+        hashChunksX4(key, data, counter, cvs);
+        chunks = kChunksPerLeaf;
+    } else {
+        // Partial leaves keep their chunk positions within the page
+        size_t offset = addr % kTreeLeafSize;
+        size_t firstChunk = offset / kTreeChunkSize;
+        size_t lastChunk = (offset + len - 1) / kTreeChunkSize;
+
+        chunks = 0;
+        for (size_t c = firstChunk; c <= lastChunk; c++) {
+            size_t from = std::max(offset, c * kTreeChunkSize);
+            size_t to = std::min(offset + len, (c + 1) * kTreeChunkSize);
+            hashChunk(key, data + (from - offset), to - from, counter + c, cvs[chunks++].words);
+        }
+    }
+
+    mergeCvs(key, cvs, chunks);
+    return cvs[0];
+}
+
+void treeHashLeaves(const TreeHashKey& key, const void* addr, size_t size,
+                    size_t first, size_t count, TreeDigest* out) {
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* data;
+        size_t len;
+        treeLeafBounds(addr, size, first + i, &data, &len);
+        out[i] = treeHashLeaf(key, data, len);
+    }
+}
+
+TreeDigest treeHashRoot(const TreeHashKey& key, const TreeDigest* leaves,
+                        size_t count, uint64_t totalLen) {
+    std::vector<TreeDigest> cvs(leaves, leaves + count);
+    if (cvs.empty()) {
+        cvs.push_back(TreeDigest{});
+    }
+    mergeCvs(key, cvs.data(), cvs.size());
+
+    // Finalize over (tree root, length) so truncated regions never collide
+    uint8_t block[kBlockSize] = {0};
+    memcpy(block, cvs[0].words, 32);
+    memcpy(block + 32, &totalLen, sizeof(totalLen));
+
+    TreeDigest root;
+    memcpy(root.words, key.words, sizeof(key.words));
+    compress(root.words, block, 40, 0, PARENT | ROOT | KEYED_HASH);
+    return root;
+}
+
+TreeDigest treeHashRegion(const TreeHashKey& key, const void* addr, size_t size,
+                          TreeDigest* leaves, unsigned maxThreads) {
+    size_t count = treeLeafCount(addr, size);
+    std::vector<TreeDigest> scratch;
+    if (!leaves) {
+        scratch.resize(count);
+        leaves = scratch.data();
+    }
+
+    // Leaves are independent, so each worker takes a contiguous slice
+    parallelFor(count, maxThreads, kLeavesPerWorker, [&](size_t first, size_t n) {
+        treeHashLeaves(key, addr, size, first, n, leaves + first);
+    });
+
+    return treeHashRoot(key, leaves, count, size);
+}
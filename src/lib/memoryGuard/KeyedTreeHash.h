@@ -0,0 +1,58 @@
+#ifndef STFU_KEYED_TREE_HASH_H
+#define STFU_KEYED_TREE_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// BLAKE3-style keyed tree hash used to MAC protected memory regions.
+//
+// A region is split into leaves aligned to absolute 4 KiB boundaries, so a
+// leaf can be re-hashed on its own when only part of a region changes. Each
+// leaf is made of up to four 1 KiB chunks; full leaves compress their four
+// chunks side by side in 128-bit vector lanes. Chunk counters are derived from
+// the absolute page number, which binds every leaf to its address.
+
+constexpr size_t kTreeChunkSize = 1024;
+constexpr size_t kTreeLeafSize = 4096;
+
+struct TreeHashKey {
+    uint32_t words[8];
+};
+
+struct TreeDigest {
+    uint32_t words[8];
+};
+
+inline bool operator==(const TreeDigest& a, const TreeDigest& b) {
+    return memcmp(a.words, b.words, sizeof(a.words)) == 0;
+}
+
+inline bool operator!=(const TreeDigest& a, const TreeDigest& b) {
+    return !(a == b);
+}
+
+// Number of leaves spanned by [addr, addr + size)
+size_t treeLeafCount(const void* addr, size_t size);
+
+// Bounds of one leaf of a region
+void treeLeafBounds(const void* addr, size_t size, size_t leaf,
+                    const uint8_t** leafData, size_t* leafLen);
+
+// Hash a single leaf. `data` must start at or after the leaf's page boundary.
+TreeDigest treeHashLeaf(const TreeHashKey& key, const uint8_t* data, size_t len);
+
+// Hash leaves [first, first + count) of a region into `out`
+void treeHashLeaves(const TreeHashKey& key, const void* addr, size_t size,
+                    size_t first, size_t count, TreeDigest* out);
+
+// Combine leaf digests into the region root
+TreeDigest treeHashRoot(const TreeHashKey& key, const TreeDigest* leaves,
+                        size_t count, uint64_t totalLen);
+
+// Hash a whole region, splitting large regions across worker threads.
+// `leaves` may be null; otherwise it receives treeLeafCount() digests.
+TreeDigest treeHashRegion(const TreeHashKey& key, const void* addr, size_t size,
+                          TreeDigest* leaves, unsigned maxThreads);
+
+#endif // STFU_KEYED_TREE_HASH_H
@@ -0,0 +1,48 @@
+#include "LivenessMonitor.h"
+
+int livenessRegister(LivenessMonitor& monitor, int64_t deadlineNs) {
+    if (deadlineNs <= 0) return -1;
+
+    for (size_t i = 0; i < kLivenessSlots; i++) {
+        int64_t expected = 0;
+        if (monitor.slots[i].deadlineNs.compare_exchange_strong(expected, deadlineNs,
+                                                               std::memory_order_acq_rel)) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void livenessUnregister(LivenessMonitor& monitor, int slot) {
+    if (slot < 0 || slot >= static_cast<int>(kLivenessSlots)) return;
+    monitor.slots[slot].deadlineNs.store(0, std::memory_order_release);
+}
+
+uint32_t livenessCheck(LivenessMonitor& monitor, LivenessChecker& checker, int self,
+                       int64_t nowNs, int64_t maxGapNs) {
+    bool rebase = checker.lastCheckNs == 0 || nowNs - checker.lastCheckNs > maxGapNs;
+    checker.lastCheckNs = nowNs;
+
+    uint32_t missed = 0;
+    for (size_t i = 0; i < kLivenessSlots; i++) {
+        int64_t deadline = monitor.slots[i].deadlineNs.load(std::memory_order_acquire);
+        if (deadline == 0 || static_cast<int>(i) == self) {
+            checker.seenAtNs[i] = 0;
+            continue;
+        }
+
+        uint64_t epoch = monitor.slots[i].epoch.load(std::memory_order_acquire);
+        if (rebase || checker.seenAtNs[i] == 0 || epoch != checker.seenEpoch[i]) {
+            checker.seenEpoch[i] = epoch;
+            checker.seenAtNs[i] = nowNs;
+            checker.missed[i] = false;
+            continue;
+        }
+
+        if (!checker.missed[i] && nowNs - checker.seenAtNs[i] > deadline) {
+            checker.missed[i] = true;
+            missed |= 1u << i;
+        }
+    }
+    return missed;
+}
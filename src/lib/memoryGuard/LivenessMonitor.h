@@ -0,0 +1,66 @@
+#ifndef STFU_LIVENESS_MONITOR_H
+#define STFU_LIVENESS_MONITOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Liveness tracking for the threads that run detection.
+//
+// Suspending the one thread that runs the integrity checks stops all
+// protection without a trace. So each detector thread owns a slot and
+// bumps its epoch every time it does a round of work, and a peer thread
+// checks that every other slot's epoch moves within the slot's deadline.
+// The stall watchdog and the Java integrity thread check each other, so
+// freezing either one is noticed by the other.
+//
+// Lock-free throughout:
+//  - Each slot is its own cache line and has a single writer, so a beat is
+//    one relaxed store that never bounces a line another beater writes.
+//  - Checkers keep what they last saw in their own LivenessChecker, never
+//    in the slots.
+//  - Slots are claimed by CAS on the deadline.
+//
+// A checker that was itself absent for longer than its own cadence (the
+// whole process frozen, or the device asleep) cannot blame anyone for that
+// gap. It rebases its view instead, and the stall watchdog reports the
+// freeze.
+
+constexpr size_t kLivenessSlots = 8;
+
+struct alignas(64) LivenessSlot {
+    std::atomic<uint64_t> epoch{0};
+    std::atomic<int64_t> deadlineNs{0}; // 0 while the slot is free
+};
+
+struct LivenessMonitor {
+    LivenessSlot slots[kLivenessSlots];
+};
+
+// One checker's private view of every slot
+struct LivenessChecker {
+    uint64_t seenEpoch[kLivenessSlots] = {};
+    int64_t seenAtNs[kLivenessSlots] = {};
+    bool missed[kLivenessSlots] = {};
+    int64_t lastCheckNs = 0;
+};
+
+// Claim a slot whose owner must beat at least every deadlineNs. Returns
+// the slot index, or -1 if all slots are taken.
+int livenessRegister(LivenessMonitor& monitor, int64_t deadlineNs);
+void livenessUnregister(LivenessMonitor& monitor, int slot);
+
+// Called by the slot's owner after each round of work
+inline void livenessBeat(LivenessMonitor& monitor, int slot) {
+    std::atomic<uint64_t>& epoch = monitor.slots[slot].epoch;
+    epoch.store(epoch.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+// Check every registered slot except `self`. Returns a bitmask of slots
+// that newly missed their deadline; each miss is reported once until the
+// slot beats again. maxGapNs is the checker's own expected cadence; a
+// longer gap since its last check rebases instead of reporting.
+uint32_t livenessCheck(LivenessMonitor& monitor, LivenessChecker& checker, int self,
+                       int64_t nowNs, int64_t maxGapNs);
+
+#endif // STFU_LIVENESS_MONITOR_H
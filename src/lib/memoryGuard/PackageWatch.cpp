@@ -0,0 +1,73 @@
+#include "PackageWatch.h"
+
+#include <errno.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ShieldLog.h"
+
+// Entries appearing or disappearing; content changes inside them do not matter
+constexpr uint32_t kWatchMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+static bool sameTime(const timespec& a, const timespec& b) {
+    return a.tv_sec == b.tv_sec && a.tv_nsec == b.tv_nsec;
+}
+
+void packageWatchStart(PackageWatch& watch, const char* const* dirs, size_t count) {
+    packageWatchStop(watch);
+    watch.inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    for (size_t i = 0; i < count; i++) {
+        if (watch.inotifyFd >= 0 && inotify_add_watch(watch.inotifyFd, dirs[i], kWatchMask) >= 0) {
+            watch.inotifyCount++;
+            continue;
+        }
+        struct stat st;
+        if (watch.mtimeCount < kPackageWatchDirs && stat(dirs[i], &st) == 0) {
+            watch.mtimeDirs[watch.mtimeCount] = dirs[i];
+            watch.mtimes[watch.mtimeCount] = st.st_mtim;
+            watch.mtimeCount++;
+        }
+    }
+    if (watch.inotifyCount == 0 && watch.inotifyFd >= 0) {
+        close(watch.inotifyFd);
+        watch.inotifyFd = -1;
+    }
+    watch.dirty.store(true);
+    LOGI("Package watch: %zu inotify, %zu mtime directories", watch.inotifyCount, watch.mtimeCount);
+}
+
+void packageWatchStop(PackageWatch& watch) {
+    if (watch.inotifyFd >= 0) close(watch.inotifyFd);
+    watch.inotifyFd = -1;
+    watch.inotifyCount = 0;
+    watch.mtimeCount = 0;
+}
+
+void packageWatchMarkChanged(PackageWatch& watch) {
+    watch.dirty.store(true, std::memory_order_release);
+}
+
+bool packageWatchPoll(PackageWatch& watch) {
+    bool changed = watch.dirty.exchange(false, std::memory_order_acq_rel);
+
+    if (watch.inotifyFd >= 0) {
+        // Only whether anything arrived matters; drain and discard
+        alignas(inotify_event) char events[4096];
+        while (read(watch.inotifyFd, events, sizeof(events)) > 0) {
+            changed = true;
+        }
+    }
+
+    for (size_t i = 0; i < watch.mtimeCount; i++) {
+        struct stat st;
+        if (stat(watch.mtimeDirs[i], &st) != 0) continue;
+        if (!sameTime(st.st_mtim, watch.mtimes[i])) {
+            watch.mtimes[i] = st.st_mtim;
+            changed = true;
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,50 @@
+#ifndef STFU_PACKAGE_WATCH_H
+#define STFU_PACKAGE_WATCH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <time.h>
+
+// Change detector for the installed package set, so the cheat package check
+// runs on events instead of every tick.
+//
+// Installs are rare, but asking PackageManager about every blocklisted
+// package costs one binder call each. Here the full comparison runs once,
+// and its result is cached until something suggests the set changed:
+//  - a package broadcast (ACTION_PACKAGE_ADDED/REPLACED/REMOVED) relayed
+//    from Java through packageWatchMarkChanged();
+//  - an inotify event on a watched directory;
+//  - a changed mtime on a watched directory that inotify refuses. App
+//    sandboxes may search /data/app and /data/data but not read them, and
+//    creating or removing an entry still updates the directory's mtime.
+// Polling is one non-blocking read of the inotify fd and one stat per
+// mtime-watched directory; nothing is rescanned until one of them fires.
+
+constexpr size_t kPackageWatchDirs = 8;
+
+struct PackageWatch {
+    int inotifyFd = -1;
+    const char* mtimeDirs[kPackageWatchDirs] = {};
+    timespec mtimes[kPackageWatchDirs] = {};
+    size_t mtimeCount = 0;
+    size_t inotifyCount = 0;
+
+    std::atomic<bool> dirty{true}; // Starts set so the first poll runs a full comparison
+};
+
+// Watch `dirs` (string literals; they are kept, not copied). Directories
+// that exist but cannot be watched with inotify fall back to mtime checks.
+void packageWatchStart(PackageWatch& watch, const char* const* dirs, size_t count);
+
+void packageWatchStop(PackageWatch& watch);
+
+// Safe from any thread
+void packageWatchMarkChanged(PackageWatch& watch);
+
+// True when the cached comparison may be stale, and the caller should
+// rerun it. Consumes the pending events, so a change that lands during the
+// rerun shows up on the next poll.
+bool packageWatchPoll(PackageWatch& watch);
+
+#endif // STFU_PACKAGE_WATCH_H
@@ -0,0 +1,99 @@
+#include "PageResidency.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+constexpr uint64_t kPagemapPresent = 1ull << 63;
+constexpr uint64_t kPagemapSwapped = 1ull << 62;
+constexpr uint64_t kPagemapFile = 1ull << 61;
+
+int pagemapOpen() {
+    return open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+}
+
+void pagemapClose(int fd) {
+    if (fd >= 0) close(fd);
+}
+
+void pagemapWindowInit(PagemapWindow& window, int fd) {
+    window.fd = fd;
+    window.pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    window.first = 0;
+    window.count = 0;
+}
+
+PageState pageState(PagemapWindow& window, const void* addr) {
+    if (window.fd < 0) return PAGE_UNKNOWN;
+
+    uintptr_t page = reinterpret_cast<uintptr_t>(addr) / window.pageSize;
+    if (page < window.first || page >= window.first + window.count) {
+        ssize_t got = pread(window.fd, window.entries, sizeof(window.entries),
+                            static_cast<off_t>(page * sizeof(uint64_t)));
+        if (got < static_cast<ssize_t>(sizeof(uint64_t))) {
+            window.count = 0;
+            return PAGE_UNKNOWN;
+        }
+        window.first = page;
+        window.count = static_cast<size_t>(got) / sizeof(uint64_t);
+    }
+
+    uint64_t entry = window.entries[page - window.first];
+    if (entry & kPagemapPresent) return entry & kPagemapFile ? PAGE_FILE : PAGE_PRESENT;
+    if (entry & kPagemapSwapped) return PAGE_SWAPPED;
+    return PAGE_UNPOPULATED;
+}
+
+// Parse a number in `base` at *p, stopping at `end`
+static uint64_t parseNumber(const char** p, const char* end, int base) {
+    uint64_t value = 0;
+    for (; *p < end; (*p)++) {
+        char c = **p;
+        int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (base == 16 && c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else break;
+        value = value * base + digit;
+    }
+    return value;
+}
+
+static void skipField(const char** p, const char* end) {
+    while (*p < end && **p != ' ' && **p != '\n') (*p)++;
+    while (*p < end && **p == ' ') (*p)++;
+}
+
+// Lines are "start-end perms offset major:minor inode [path]", by address
+MappingKind classifyMapping(const char* maps, size_t length, const void* addr, size_t size) {
+    uint64_t cursor = reinterpret_cast<uintptr_t>(addr);
+    uint64_t limit = cursor + size;
+    MappingKind kind = MAPPING_UNKNOWN;
+
+    const char* end = maps + length;
+    for (const char* line = maps; line < end && cursor < limit; ) {
+        const char* p = line;
+        uint64_t start = parseNumber(&p, end, 16);
+        if (p < end && *p == '-') p++;
+        uint64_t stop = parseNumber(&p, end, 16);
+        while (p < end && *p == ' ') p++;
+        bool isPrivate = end - p >= 4 && p[3] == 'p';
+        skipField(&p, end); // perms
+        skipField(&p, end); // offset
+        skipField(&p, end); // device
+        uint64_t inode = parseNumber(&p, end, 10);
+
+        while (line < end && *line != '\n') line++;
+        line++;
+
+        if (stop <= cursor) continue;
+        if (start > cursor) return MAPPING_UNKNOWN; // Hole in the range
+
+        MappingKind lineKind = !isPrivate ? MAPPING_UNKNOWN
+                : inode == 0 ? MAPPING_ANONYMOUS : MAPPING_FILE;
+        if (lineKind == MAPPING_UNKNOWN || (kind != MAPPING_UNKNOWN && lineKind != kind)) {
+            return MAPPING_UNKNOWN;
+        }
+        kind = lineKind;
+        cursor = stop;
+    }
+    return cursor >= limit ? kind : MAPPING_UNKNOWN;
+}
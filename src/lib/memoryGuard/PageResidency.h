@@ -0,0 +1,66 @@
+#ifndef STFU_PAGE_RESIDENCY_H
+#define STFU_PAGE_RESIDENCY_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Page residency from /proc/self/pagemap, so verifiers can leave pages the
+// process never populated alone instead of faulting them in to hash them.
+//
+// pagemap is used rather than mincore because mincore reports a page that
+// was swapped out (zram on most Android devices) the same as one that was
+// never touched; only the latter is known to read as zero. Each entry is
+// 8 bytes per page: bit 63 present, bit 62 swapped, bit 61 file page.
+// Page frame numbers are hidden from unprivileged readers, but the flags
+// are not.
+//
+// The file bit makes private file mappings (code, rodata, mmap'd assets)
+// checkable without reading them: the first write to such a page, from
+// the process or through /proc/pid/mem, replaces it with an anonymous
+// copy. In a shared mapping writes leave the bit alone, so only private
+// mappings qualify; classifyMapping() tells them apart from /proc/self/maps.
+//
+// Lookups go through a window of entries read ahead with one pread, so a
+// sequential walk costs one syscall per 2 MiB of 4 KiB pages. Opening and
+// reading are async-signal-safe and allocation-free, which the snapshot
+// child relies on.
+
+enum PageState : uint8_t {
+    PAGE_UNPOPULATED = 0, // Neither present nor swapped
+    PAGE_PRESENT = 1,     // Present anonymous page
+    PAGE_FILE = 2,        // Present page cache or shared anonymous page
+    PAGE_SWAPPED = 3,
+    PAGE_UNKNOWN = 4,     // pagemap unavailable; treat as present
+};
+
+enum MappingKind : uint8_t {
+    MAPPING_UNKNOWN = 0,   // Shared, mixed, unmapped or not looked up
+    MAPPING_ANONYMOUS = 1, // Private anonymous
+    MAPPING_FILE = 2,      // Private file mapping
+};
+
+constexpr size_t kPagemapWindow = 512; // Entries per read
+
+struct PagemapWindow {
+    int fd;           // Borrowed from pagemapOpen(); -1 makes every page PAGE_UNKNOWN
+    size_t pageSize;
+    uintptr_t first;  // Page number of entries[0]
+    size_t count;     // Valid entries
+    uint64_t entries[kPagemapWindow];
+};
+
+// Open /proc/self/pagemap for this process; -1 where it is not readable
+int pagemapOpen();
+void pagemapClose(int fd);
+
+void pagemapWindowInit(PagemapWindow& window, int fd);
+
+// State of the page holding `addr`
+PageState pageState(PagemapWindow& window, const void* addr);
+
+// Kind of the mappings covering [addr, addr + size), given the text of
+// /proc/self/maps. A range spanning several mappings has a kind only if
+// they are contiguous and all of that kind.
+MappingKind classifyMapping(const char* maps, size_t length, const void* addr, size_t size);
+
+#endif // STFU_PAGE_RESIDENCY_H
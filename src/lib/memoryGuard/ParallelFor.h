@@ -0,0 +1,34 @@
+#ifndef STFU_PARALLEL_FOR_H
+#define STFU_PARALLEL_FOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Split [0, count) into contiguous slices and run fn(first, n) on each.
+// The calling thread takes the first slice; no more than maxThreads run and
+// every worker gets at least minPerWorker items.
+template <typename Fn>
+void parallelFor(size_t count, unsigned maxThreads, size_t minPerWorker, Fn fn) {
+    size_t workers = std::min<size_t>(maxThreads, count / std::max<size_t>(minPerWorker, 1));
+    if (workers <= 1) {
+        if (count > 0) fn(static_cast<size_t>(0), count);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    size_t per = (count + workers - 1) / workers;
+    for (size_t w = 1; w < workers; w++) {
+        size_t first = w * per;
+        if (first >= count) break;
+        size_t n = std::min(per, count - first);
+        threads.emplace_back([&fn, first, n]() { fn(first, n); });
+    }
+    fn(static_cast<size_t>(0), std::min(per, count));
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+#endif // STFU_PARALLEL_FOR_H
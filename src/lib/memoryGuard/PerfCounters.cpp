@@ -0,0 +1,139 @@
+#include "PerfCounters.h"
+
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstring>
+
+struct PerfEvent {
+    uint32_t type;
+    uint64_t config;
+};
+
+// Indexed by PerfCounter
+static const PerfEvent kPerfEvents[kPerfCounters] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+};
+
+constexpr int kRusageCounter = -2; // fd slot counted with getrusage() instead
+
+// This thread's counters, opened on its first instrumented run
+struct ThreadCounters {
+    bool opened = false;
+    int fd[kPerfCounters];
+
+    ~ThreadCounters() {
+        if (!opened) return;
+        for (int f : fd) {
+            if (f >= 0) close(f);
+        }
+    }
+};
+
+static thread_local ThreadCounters threadCounters;
+
+static int64_t monotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static int openEvent(const PerfEvent& event, bool excludeKernel) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.exclude_kernel = excludeKernel;
+    attr.exclude_hv = 1;
+    attr.inherit = 1;
+    attr.inherit_thread = 1; // Threads only: keep the snapshot child out
+
+    int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+    if (fd < 0 && errno == EINVAL) {
+        // inherit_thread is Linux 5.13+; count the calling thread alone
+        attr.inherit = 0;
+        attr.inherit_thread = 0;
+        fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+    }
+    return fd;
+}
+
+static void openThreadCounters(ThreadCounters& counters) {
+    counters.opened = true;
+    for (size_t i = 0; i < kPerfCounters; i++) {
+        int fd = openEvent(kPerfEvents[i], false);
+        if (fd < 0 && errno == EACCES) {
+            // perf_event_paranoid >= 2: user space only. Context switches
+            // happen in the kernel and would always read 0 there
+            fd = i == PERF_CONTEXT_SWITCHES ? kRusageCounter : openEvent(kPerfEvents[i], true);
+        }
+        counters.fd[i] = fd;
+    }
+}
+
+// Value, time enabled and time running of one counter
+static bool readCounter(int fd, uint64_t out[3]) {
+    if (fd == kRusageCounter) {
+        rusage usage;
+        if (getrusage(RUSAGE_THREAD, &usage) != 0) return false;
+        out[0] = static_cast<uint64_t>(usage.ru_nvcsw + usage.ru_nivcsw);
+        out[1] = out[2] = 0;
+        return true;
+    }
+    return fd >= 0 && read(fd, out, 3 * sizeof(uint64_t)) == static_cast<ssize_t>(3 * sizeof(uint64_t));
+}
+
+ScopedPerfCounters::ScopedPerfCounters(DetectorStats* stats) : stats(stats) {
+    if (!stats) return;
+
+    if (!threadCounters.opened) {
+        openThreadCounters(threadCounters);
+    }
+    for (size_t i = 0; i < kPerfCounters; i++) {
+        valid[i] = readCounter(threadCounters.fd[i], start[i]);
+    }
+    startNs = monotonicNs();
+}
+
+ScopedPerfCounters::~ScopedPerfCounters() {
+    if (!stats) return;
+
+    int64_t endNs = monotonicNs();
+    for (size_t i = 0; i < kPerfCounters; i++) {
+        uint64_t end[3];
+        if (!valid[i] || !readCounter(threadCounters.fd[i], end)) continue;
+
+        uint64_t delta = end[0] - start[i][0];
+        uint64_t enabled = end[1] - start[i][1];
+        uint64_t running = end[2] - start[i][2];
+        if (running == 0 && enabled > 0) continue; // Never got a hardware counter
+        if (running < enabled) {
+            // Multiplexed with other events; extrapolate to the whole run
+            delta = static_cast<uint64_t>(static_cast<double>(delta) * enabled / running);
+        }
+        stats->counts[i].fetch_add(delta, std::memory_order_relaxed);
+        stats->measuredRuns[i].fetch_add(1, std::memory_order_relaxed);
+    }
+    stats->wallNs.fetch_add(static_cast<uint64_t>(endNs - startNs), std::memory_order_relaxed);
+    stats->runs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void detectorStatsRead(const DetectorStats& stats, int64_t out[kDetectorStatsFields]) {
+    out[0] = static_cast<int64_t>(stats.runs.load(std::memory_order_relaxed));
+    out[1] = static_cast<int64_t>(stats.wallNs.load(std::memory_order_relaxed));
+    for (size_t i = 0; i < kPerfCounters; i++) {
+        out[2 + i] = stats.measuredRuns[i].load(std::memory_order_relaxed) > 0
+                ? static_cast<int64_t>(stats.counts[i].load(std::memory_order_relaxed))
+                : -1;
+    }
+}
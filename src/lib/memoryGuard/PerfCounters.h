@@ -0,0 +1,75 @@
+#ifndef STFU_PERF_COUNTERS_H
+#define STFU_PERF_COUNTERS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Optional per-detector CPU counters from perf_event_open, to explain why a
+// detector is slow on a particular SoC rather than only how long it took.
+//
+// Each thread that runs an instrumented detector opens one counter per event
+// the first time, counting that thread and the threads it starts afterwards
+// (the hash workers), but not forked processes such as the snapshot child.
+// A run reads every counter before and after and adds the difference to
+// the detector's totals, scaled up when the PMU had to multiplex hardware
+// counters. Workers' counts are folded in by the kernel as they exit, so a
+// run can pick up the tail of a previous run's workers.
+//
+// Counters include kernel time (a /proc read is almost all kernel) where
+// perf_event_paranoid allows it. Otherwise hardware counters and page faults
+// fall back to user space only. Context switches only happen in the kernel,
+// so they fall back to the calling thread's getrusage() instead. Release
+// Android builds deny perf_event_open to apps entirely
+// (security.perf_harden) and the hardware events need a PMU; a counter that
+// never opened reports -1.
+//
+// Off by default: reads cost a syscall per counter at each end of a run.
+
+enum PerfCounter {
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS = 1,
+    PERF_CACHE_MISSES = 2,
+    PERF_PAGE_FAULTS = 3,
+    PERF_CONTEXT_SWITCHES = 4,
+};
+
+constexpr size_t kPerfCounters = 5;
+
+// Instrumented detector runs; must match GameGuardianShield.DETECTOR_*
+enum Detector {
+    DETECTOR_MEMORY = 0,      // nativeCheckProtectedMemory
+    DETECTOR_VALUES = 1,      // nativeCheckProtectedValues
+    DETECTOR_CHEAT_TOOLS = 2, // detectCheatTools, including the maps scan
+    DETECTOR_ATTESTATION = 3, // nativeAttest
+};
+
+constexpr size_t kDetectors = 4;
+
+struct DetectorStats {
+    std::atomic<uint64_t> runs{0};
+    std::atomic<uint64_t> wallNs{0};
+    std::atomic<uint64_t> counts[kPerfCounters] = {};
+    std::atomic<uint64_t> measuredRuns[kPerfCounters] = {}; // Runs in which the counter was open
+};
+
+// Totals as reported through the stats API: runs, wall time in ns, then
+// one value per PerfCounter, -1 for counters that were never measured
+constexpr size_t kDetectorStatsFields = 2 + kPerfCounters;
+void detectorStatsRead(const DetectorStats& stats, int64_t out[kDetectorStatsFields]);
+
+// Attribute the calling thread's counters over the scope to `stats`;
+// null makes it a no-op
+struct ScopedPerfCounters {
+    explicit ScopedPerfCounters(DetectorStats* stats);
+    ~ScopedPerfCounters();
+    ScopedPerfCounters(const ScopedPerfCounters&) = delete;
+    ScopedPerfCounters& operator=(const ScopedPerfCounters&) = delete;
+
+    DetectorStats* stats;
+    int64_t startNs = 0;
+    uint64_t start[kPerfCounters][3] = {}; // value, time enabled, time running
+    bool valid[kPerfCounters] = {};
+};
+
+#endif // STFU_PERF_COUNTERS_H
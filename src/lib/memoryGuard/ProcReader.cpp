@@ -0,0 +1,309 @@
+#include "ProcReader.h"
+
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+#include "ShieldLog.h"
+
+#if defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define STFU_HAVE_IO_URING 1
+#endif
+
+// user_data: read index in the high 32 bits, 0 for its OPENAT or
+// 1 + slot within the read for a READ_FIXED
+static inline uint64_t encodeTag(size_t read, size_t part) {
+    return (static_cast<uint64_t>(read) << 32) | part;
+}
+
+static void teardownRing(ProcReader& reader) {
+    if (reader.sqes) munmap(reader.sqes, reader.sqesBytes);
+    if (reader.cqRing && reader.cqRing != reader.sqRing) munmap(reader.cqRing, reader.cqRingBytes);
+    if (reader.sqRing) munmap(reader.sqRing, reader.sqRingBytes);
+    if (reader.ringFd >= 0) close(reader.ringFd);
+
+    reader.sqes = nullptr;
+    reader.cqRing = nullptr;
+    reader.sqRing = nullptr;
+    reader.ringFd = -1;
+}
+
+#ifdef STFU_HAVE_IO_URING
+
+static bool setupRing(ProcReader& reader) {
+    // Worst case per batch: one OPENAT per read plus one READ_FIXED per slot
+    io_uring_params params = {};
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup,
+                                      static_cast<unsigned>(reader.slotCount * 2), &params));
+    if (fd < 0) return false;
+    reader.ringFd = fd;
+
+    reader.sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    reader.cqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single && reader.cqRingBytes > reader.sqRingBytes) {
+        reader.sqRingBytes = reader.cqRingBytes;
+    }
+
+    void* sq = mmap(nullptr, reader.sqRingBytes, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED) return false;
+    reader.sqRing = sq;
+
+    void* cq = sq;
+    if (!single) {
+        cq = mmap(nullptr, reader.cqRingBytes, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cq == MAP_FAILED) return false;
+    }
+    reader.cqRing = cq;
+
+    reader.sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, reader.sqesBytes, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) return false;
+    reader.sqes = sqes;
+
+    uint8_t* sqBase = static_cast<uint8_t*>(sq);
+    uint8_t* cqBase = static_cast<uint8_t*>(cq);
+    reader.sqEntries = params.sq_entries;
+    reader.cqEntries = params.cq_entries;
+    reader.sqHead = reinterpret_cast<unsigned*>(sqBase + params.sq_off.head);
+    reader.sqTail = reinterpret_cast<unsigned*>(sqBase + params.sq_off.tail);
+    reader.sqMask = reinterpret_cast<unsigned*>(sqBase + params.sq_off.ring_mask);
+    reader.sqArray = reinterpret_cast<unsigned*>(sqBase + params.sq_off.array);
+    reader.cqHead = reinterpret_cast<unsigned*>(cqBase + params.cq_off.head);
+    reader.cqTail = reinterpret_cast<unsigned*>(cqBase + params.cq_off.tail);
+    reader.cqMask = reinterpret_cast<unsigned*>(cqBase + params.cq_off.ring_mask);
+    reader.cqes = cqBase + params.cq_off.cqes;
+
+    // Every slot is a registered buffer; file slots start out empty
+    std::vector<iovec> buffers(reader.slotCount);
+    for (size_t i = 0; i < reader.slotCount; i++) {
+        buffers[i].iov_base = reader.arena + i * reader.slotBytes;
+        buffers[i].iov_len = reader.slotBytes;
+    }
+    if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS,
+                buffers.data(), static_cast<unsigned>(reader.slotCount)) != 0) {
+        return false;
+    }
+
+    std::vector<int> files(reader.slotCount, -1);
+    return syscall(__NR_io_uring_register, fd, IORING_REGISTER_FILES,
+                   files.data(), static_cast<unsigned>(reader.slotCount)) == 0;
+}
+
+static size_t batchRing(ProcReader& reader, ProcRead* reads, size_t count) {
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(reader.sqes);
+    io_uring_cqe* cqes = static_cast<io_uring_cqe*>(reader.cqes);
+
+    std::vector<size_t> firstSlot(count);
+    std::vector<int32_t> slotResult(reader.slotCount, 0);
+    std::vector<int32_t> openResult(count, -ECANCELED);
+
+    unsigned tail = *reader.sqTail;
+    unsigned queued = 0;
+    size_t slot = 0;
+    size_t filled = 0;
+
+    for (; filled < count; filled++) {
+        ProcRead& read = reads[filled];
+        size_t slots = read.slots ? read.slots : 1;
+        if (slot + slots > reader.slotCount) break;
+
+        // Reads only run if the open succeeded. They are hard-linked to
+        // each other because seq_file hands out about a page per read, so a
+        // short read does not mean the end of the file.
+        io_uring_sqe* sqe = &sqes[(tail + queued) & *reader.sqMask];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->flags = IOSQE_IO_LINK;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = reinterpret_cast<uint64_t>(read.path);
+        sqe->open_flags = O_RDONLY; // Direct descriptors reject O_CLOEXEC
+        sqe->file_index = static_cast<uint32_t>(filled + 1);
+        sqe->user_data = encodeTag(filled, 0);
+        reader.sqArray[(tail + queued) & *reader.sqMask] = (tail + queued) & *reader.sqMask;
+        queued++;
+
+        for (size_t j = 0; j < slots; j++) {
+            sqe = &sqes[(tail + queued) & *reader.sqMask];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_READ_FIXED;
+            sqe->flags = IOSQE_FIXED_FILE | (j + 1 < slots ? IOSQE_IO_HARDLINK : 0);
+            sqe->fd = static_cast<int>(filled);
+            sqe->addr = reinterpret_cast<uint64_t>(reader.arena + (slot + j) * reader.slotBytes);
+            sqe->len = static_cast<uint32_t>(reader.slotBytes);
+            sqe->off = static_cast<uint64_t>(-1); // Continue from the file position
+            sqe->buf_index = static_cast<uint16_t>(slot + j);
+            sqe->user_data = encodeTag(filled, j + 1);
+            reader.sqArray[(tail + queued) & *reader.sqMask] = (tail + queued) & *reader.sqMask;
+            queued++;
+        }
+
+        firstSlot[filled] = slot;
+        read.data = reinterpret_cast<const char*>(reader.arena + slot * reader.slotBytes);
+        slot += slots;
+    }
+    if (queued == 0) return 0;
+
+    __atomic_store_n(reader.sqTail, tail + queued, __ATOMIC_RELEASE);
+
+    // One enter submits everything and waits for every completion
+    unsigned reaped = 0;
+    unsigned toSubmit = queued;
+    while (reaped < queued) {
+        long rc = syscall(__NR_io_uring_enter, reader.ringFd, toSubmit, queued - reaped,
+                          IORING_ENTER_GETEVENTS, nullptr, 0);
+        reader.syscalls++;
+        if (rc < 0 && errno != EINTR) {
+            // Stragglers would land in a later batch; use preadv from now on
+            LOGW("io_uring_enter failed: %d", errno);
+            teardownRing(reader);
+            break;
+        }
+        if (rc > 0) toSubmit -= static_cast<unsigned>(rc);
+
+        unsigned head = *reader.cqHead;
+        unsigned cqTail = __atomic_load_n(reader.cqTail, __ATOMIC_ACQUIRE);
+        for (; head != cqTail; head++, reaped++) {
+            const io_uring_cqe& cqe = cqes[head & *reader.cqMask];
+            size_t index = static_cast<size_t>(cqe.user_data >> 32);
+            size_t part = static_cast<size_t>(cqe.user_data & 0xFFFFFFFFu);
+            if (part == 0) {
+                openResult[index] = cqe.res;
+            } else {
+                slotResult[firstSlot[index] + part - 1] = cqe.res;
+            }
+        }
+        __atomic_store_n(reader.cqHead, head, __ATOMIC_RELEASE);
+    }
+
+    for (size_t i = 0; i < filled; i++) {
+        ProcRead& read = reads[i];
+        if (openResult[i] < 0) {
+            read.length = openResult[i];
+            continue;
+        }
+
+        // Pack the chunks together, stopping at end of file or an error
+        size_t slots = read.slots ? read.slots : 1;
+        uint8_t* out = reader.arena + firstSlot[i] * reader.slotBytes;
+        ssize_t length = 0;
+        for (size_t j = 0; j < slots; j++) {
+            int32_t result = slotResult[firstSlot[i] + j];
+            if (result <= 0) {
+                if (j == 0) length = result;
+                break;
+            }
+            uint8_t* chunk = reader.arena + (firstSlot[i] + j) * reader.slotBytes;
+            if (chunk != out + length) memmove(out + length, chunk, result);
+            length += result;
+        }
+        read.length = length;
+    }
+    return filled;
+}
+
+#endif // STFU_HAVE_IO_URING
+
+static size_t batchRead(ProcReader& reader, ProcRead* reads, size_t count) {
+    size_t slot = 0;
+    size_t filled = 0;
+
+    for (; filled < count; filled++) {
+        ProcRead& read = reads[filled];
+        size_t slots = read.slots ? read.slots : 1;
+        if (slot + slots > reader.slotCount) break;
+
+        uint8_t* out = reader.arena + slot * reader.slotBytes;
+        size_t capacity = slots * reader.slotBytes;
+        read.data = reinterpret_cast<const char*>(out);
+        slot += slots;
+
+        int fd = open(read.path, O_RDONLY | O_CLOEXEC);
+        reader.syscalls++;
+        if (fd < 0) {
+            read.length = -errno;
+            continue;
+        }
+
+        // seq_file returns about a page per call; keep going until EOF
+        size_t length = 0;
+        ssize_t got = 0;
+        while (length < capacity) {
+            got = ::read(fd, out + length, capacity - length);
+            reader.syscalls++;
+            if (got <= 0) break;
+            length += static_cast<size_t>(got);
+        }
+        read.length = (got < 0 && length == 0) ? -errno : static_cast<ssize_t>(length);
+        close(fd);
+        reader.syscalls++;
+    }
+    return filled;
+}
+
+bool procReaderInit(ProcReader& reader, size_t slotCount, size_t slotBytes) {
+    reader = ProcReader();
+    reader.ringFd = -1;
+    reader.slotCount = slotCount;
+    reader.slotBytes = slotBytes;
+
+    void* arena = mmap(nullptr, slotCount * slotBytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (arena == MAP_FAILED) return false;
+    reader.arena = static_cast<uint8_t*>(arena);
+
+#ifdef STFU_HAVE_IO_URING
+    if (!setupRing(reader)) {
+        teardownRing(reader);
+    } else {
+        // Direct-descriptor OPENAT needs Linux 5.15; probe once
+        const char* data;
+        if (procReadFile(reader, "/proc/self/stat", &data) <= 0) {
+            teardownRing(reader);
+        }
+    }
+    reader.syscalls = 0;
+#endif
+
+    LOGI("/proc reader: %s", reader.ringFd >= 0 ? "io_uring" : "preadv");
+    return true;
+}
+
+void procReaderDestroy(ProcReader& reader) {
+    teardownRing(reader);
+    if (reader.arena) {
+        munmap(reader.arena, reader.slotCount * reader.slotBytes);
+        reader.arena = nullptr;
+    }
+}
+
+bool procReaderUsesRing(const ProcReader& reader) {
+    return reader.ringFd >= 0;
+}
+
+size_t procReaderBatch(ProcReader& reader, ProcRead* reads, size_t count) {
+    if (!reader.arena || count == 0) return 0;
+
+#ifdef STFU_HAVE_IO_URING
+    if (reader.ringFd >= 0) {
+        return batchRing(reader, reads, count);
+    }
+#endif
+    return batchRead(reader, reads, count);
+}
+
+ssize_t procReadFile(ProcReader& reader, const char* path, const char** data) {
+    ProcRead read = {path, reader.slotCount, nullptr, -EINVAL};
+    procReaderBatch(reader, &read, 1);
+    *data = read.data;
+    return read.length;
+}
@@ -0,0 +1,72 @@
+#ifndef STFU_PROC_READER_H
+#define STFU_PROC_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+// Batched reader for small /proc files, shared by the /proc-based detectors.
+//
+// Reads land in a fixed arena of equally sized slots. With io_uring each
+// file becomes a linked chain, OPENAT into a registered file slot followed
+// by one READ_FIXED per slot into registered buffers, and a whole batch is
+// submitted and reaped with one io_uring_enter. Opening into an occupied
+// file slot replaces it, so no CLOSE is ever queued. /proc files are
+// seq_files that return about a page per read, so each slot's chunk may be
+// short and the chunks are packed together afterwards.
+//
+// Where io_uring is unavailable (old kernels, or seccomp/SELinux policy on
+// Android) each file costs open + read until EOF + close.
+
+struct ProcRead {
+    const char* path;
+    size_t slots;    // Consecutive arena slots this file may fill
+
+    // Filled in by procReaderBatch; data stays valid until the next batch
+    const char* data;
+    ssize_t length;  // Bytes read, or -errno
+};
+
+struct ProcReader {
+    uint8_t* arena;
+    size_t slotCount;
+    size_t slotBytes;
+
+    // io_uring state; ringFd < 0 means the preadv fallback is in use
+    int ringFd;
+    void* sqRing;
+    size_t sqRingBytes;
+    void* cqRing;
+    size_t cqRingBytes;
+    void* sqes;
+    size_t sqesBytes;
+    unsigned sqEntries;
+    unsigned cqEntries;
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned* sqMask;
+    unsigned* sqArray;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned* cqMask;
+    void* cqes;
+
+    uint64_t syscalls; // Made by batches so far, for cost accounting
+};
+
+// Map an arena of slotCount slots of slotBytes each and try to set up
+// io_uring over it
+bool procReaderInit(ProcReader& reader, size_t slotCount, size_t slotBytes);
+void procReaderDestroy(ProcReader& reader);
+
+// True if batches go through io_uring
+bool procReaderUsesRing(const ProcReader& reader);
+
+// Read as many of `reads` as fit in the arena, in order. Returns how many
+// were filled; callers submit the rest in a further batch.
+size_t procReaderBatch(ProcReader& reader, ProcRead* reads, size_t count);
+
+// Read one file, up to the whole arena
+ssize_t procReadFile(ProcReader& reader, const char* path, const char** data);
+
+#endif // STFU_PROC_READER_H
@@ -0,0 +1,691 @@
+#include "RegionGuard.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <sched.h>
+#include <unistd.h>
+#include <vector>
+
+#include "PageResidency.h"
+#include "ParallelFor.h"
+
+// Stable-read attempts per leaf before deferring it to the next check
+constexpr int kMaxReadRetries = 8;
+
+// Leaves per verifier thread
+constexpr size_t kLeavesPerVerifier = 64;
+
+// Scan plan granularity: about the L2 of a mobile core, so the leaves a
+// verifier thread works through stay in one address window
+constexpr size_t kScanChunkBytes = 256 << 10;
+constexpr size_t kLeavesPerChunk = kScanChunkBytes / kTreeLeafSize;
+
+// How far ahead of the leaf being hashed the scan prefetches
+constexpr size_t kPrefetchLeaves = 2;
+
+constexpr size_t kCacheLine = 64;
+
+// Scan prefetches use PRFM PLDL1STRM on arm64, which loads lines into L1
+// marked as streaming so they aren't kept in L2 at the expense of the
+// game's working set. x86 has no such hint for ordinary memory (MOVNTDQA
+// only bypasses caches for write-combining memory, and PREFETCHNTA made
+// scans slower without sparing the game's lines in the host benchmark),
+// so there the scan is left to the hardware prefetchers.
+#if defined(__aarch64__)
+constexpr bool kStreamPrefetch = true;
+#else
+constexpr bool kStreamPrefetch = false;
+#endif
+
+// Smaller anonymous regions are read without asking pagemap first
+constexpr size_t kMinResidencyBytes = 64 << 10;
+
+// How a leaf's baseline is checked
+enum LeafKind : uint8_t {
+    LEAF_HASHED = 0,
+    LEAF_ZERO = 1, // All zero; no digest
+    LEAF_FILE = 2, // Unmodified page of a private file mapping
+};
+
+// Sealed baseline of a region, followed by leafCount digests and then
+// leafCount LeafKinds
+struct SealedRegion {
+    uint64_t address;
+    uint64_t size;
+    uint32_t mode;
+    uint32_t checksum;
+    uint64_t leafCount;
+    uint32_t mapping;
+    uint32_t reserved;
+};
+
+static SealedRegion* sealedRegion(const SealedTable& table, const MemoryRegion& region) {
+    return sealedTableAt<SealedRegion>(table, region.record);
+}
+
+static TreeDigest* sealedLeaves(SealedRegion* record) {
+    return reinterpret_cast<TreeDigest*>(record + 1);
+}
+
+static uint8_t* sealedLeafKinds(SealedRegion* record) {
+    return reinterpret_cast<uint8_t*>(sealedLeaves(record) + record->leafCount);
+}
+
+static uint32_t continueChecksum(uint32_t checksum, const uint8_t* ptr, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        checksum = ((checksum << 5) + checksum) + ptr[i];
+    }
+    return checksum;
+}
+
+uint32_t calculateChecksum(void* addr, size_t size) {
+    if (!addr || size == 0) return 0;
+    return continueChecksum(0, static_cast<uint8_t*>(addr), size);
+}
+
+// A zero byte multiplies the checksum by 33, so a run of them is one
+// multiply by 33^n
+static uint32_t zeroRunFactor(size_t n) {
+    uint32_t factor = 1;
+    uint32_t base = 33;
+    for (; n; n >>= 1) {
+        if (n & 1) factor *= base;
+        base *= base;
+    }
+    return factor;
+}
+
+static bool bytesAreZero(const uint8_t* data, size_t len) {
+    size_t i = 0;
+    for (; i + 64 <= len; i += 64) {
+        uint64_t words[8];
+        memcpy(words, data + i, sizeof(words));
+        uint64_t any = 0;
+        for (uint64_t word : words) any |= word;
+        if (any) return false;
+    }
+    for (; i < len; i++) {
+        if (data[i]) return false;
+    }
+    return true;
+}
+
+// Whether checks of a region ask pagemap first
+static bool usesResidency(const SealedRegion* record) {
+    return record->mapping == MAPPING_FILE ||
+           (record->mapping == MAPPING_ANONYMOUS && record->size >= kMinResidencyBytes);
+}
+
+// pagemap for one walk over a region, or -1 where residency doesn't apply
+static int openResidency(const SealedRegion* record) {
+    return usesResidency(record) ? pagemapOpen() : -1;
+}
+
+static PageState leafState(PagemapWindow* window, const void* data) {
+    return window ? pageState(*window, data) : PAGE_UNKNOWN;
+}
+
+// calculateChecksum over the sealed range, folding in unpopulated pages
+// of anonymous regions as zeros without reading them
+static uint32_t regionChecksum(SealedRegion* record, PagemapWindow* window) {
+    uint8_t* ptr = reinterpret_cast<uint8_t*>(record->address);
+    size_t size = static_cast<size_t>(record->size);
+    if (!window || window->fd < 0 || record->mapping != MAPPING_ANONYMOUS) {
+        return calculateChecksum(ptr, size);
+    }
+
+    uint32_t checksum = 0;
+    for (size_t offset = 0; offset < size; ) {
+        uintptr_t at = reinterpret_cast<uintptr_t>(ptr + offset);
+        size_t n = std::min(size - offset, window->pageSize - at % window->pageSize);
+        if (pageState(*window, ptr + offset) == PAGE_UNPOPULATED) {
+            checksum *= zeroRunFactor(n);
+        } else {
+            checksum = continueChecksum(checksum, ptr + offset, n);
+        }
+        offset += n;
+    }
+    return checksum;
+}
+
+// Baseline of one leaf. All-zero leaves, including unpopulated anonymous
+// pages, which are not read, are flagged rather than hashed; leaves of a
+// file mapping whose pages are still file pages are hashed but checked by
+// page state.
+static void sealLeaf(const TreeHashKey& key, const SealedRegion* record, size_t leaf,
+                     PagemapWindow* window, TreeDigest* digest, uint8_t* kind) {
+    const uint8_t* data;
+    size_t len;
+    treeLeafBounds(reinterpret_cast<void*>(record->address), static_cast<size_t>(record->size),
+                   leaf, &data, &len);
+    PageState state = leafState(window, data);
+    bool file = record->mapping == MAPPING_FILE;
+
+    if (!file && (state == PAGE_UNPOPULATED || bytesAreZero(data, len))) {
+        *kind = LEAF_ZERO;
+        *digest = TreeDigest{};
+        return;
+    }
+
+    *digest = treeHashLeaf(key, data, len);
+    // An unpopulated file page will be read from the file when touched;
+    // one that was copied on write before sealing stays hashed
+    *kind = file && (state == PAGE_FILE || state == PAGE_UNPOPULATED) ? LEAF_FILE : LEAF_HASHED;
+}
+
+// Record the baseline of leaves [first, first + count)
+static void sealLeaves(const TreeHashKey& key, SealedRegion* record, size_t first,
+                       size_t count, PagemapWindow* window) {
+    TreeDigest* leaves = sealedLeaves(record);
+    uint8_t* kinds = sealedLeafKinds(record);
+    for (size_t i = first; i < first + count; i++) {
+        sealLeaf(key, record, i, window, &leaves[i], &kinds[i]);
+    }
+}
+
+// A unit's staged baseline if an ended write left one, else null. Read
+// without holding the unit, it is only as stable as the unit's counter.
+static const StagedUnit* stagedUnit(const MemoryRegion& region, size_t unit) {
+    const StagedUnit& staged = region.staged[unit];
+    return staged.pending.load(std::memory_order_relaxed) ? &staged : nullptr;
+}
+
+static uint8_t leafKind(SealedRegion* record, const MemoryRegion& region, size_t unit) {
+    const StagedUnit* staged = stagedUnit(region, unit);
+    return staged ? staged->kind : sealedLeafKinds(record)[unit];
+}
+
+// Sequence counters covering [offset, offset + size)
+static void seqRange(const MemoryRegion& region, size_t offset, size_t size,
+                     size_t* first, size_t* last) {
+    if (region.mode != INTEGRITY_KEYED_TREE) {
+        *first = 0;
+        *last = 0;
+        return;
+    }
+
+    uintptr_t base = reinterpret_cast<uintptr_t>(region.address) / kTreeLeafSize;
+    uintptr_t start = reinterpret_cast<uintptr_t>(region.address) + offset;
+    *first = start / kTreeLeafSize - base;
+    *last = (start + size - 1) / kTreeLeafSize - base;
+}
+
+bool sealRegion(SealedTable& table, MemoryRegion& region, unsigned threads) {
+    size_t leafCount = region.mode == INTEGRITY_KEYED_TREE
+            ? treeLeafCount(region.address, region.size) : 0;
+
+    region.record = sealedTableAllocate(table, sizeof(SealedRegion) +
+                                        leafCount * (sizeof(TreeDigest) + 1));
+    if (region.record == 0) return false;
+
+    SealedRegion* record = sealedRegion(table, region);
+    record->address = reinterpret_cast<uint64_t>(region.address);
+    record->size = region.size;
+    record->mode = static_cast<uint32_t>(region.mode);
+    record->leafCount = leafCount;
+    record->mapping = region.mapping;
+
+    int fd = openResidency(record);
+    if (region.mode == INTEGRITY_KEYED_TREE) {
+        const TreeHashKey& key = sealedTableKey(table);
+        parallelFor(leafCount, threads, kLeavesPerVerifier, [&](size_t first, size_t n) {
+            PagemapWindow window;
+            pagemapWindowInit(window, fd);
+            sealLeaves(key, record, first, n, &window);
+        });
+        region.seqCount = leafCount;
+    } else {
+        PagemapWindow window;
+        pagemapWindowInit(window, fd);
+        record->checksum = regionChecksum(record, &window);
+        region.seqCount = 1;
+    }
+    pagemapClose(fd);
+
+    region.seq.reset(new std::atomic<uint32_t>[region.seqCount]);
+    region.holder.reset(new std::atomic<int32_t>[region.seqCount]);
+    region.heldSeq.reset(new uint32_t[region.seqCount]());
+    region.heldChecks.reset(new uint8_t[region.seqCount]());
+    region.staged.reset(new StagedUnit[region.seqCount]);
+    for (size_t i = 0; i < region.seqCount; i++) {
+        region.seq[i].store(0, std::memory_order_relaxed);
+        region.holder[i].store(0, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+// Hash one unit and compare it with its baseline, staged or sealed.
+// `window` is null where residency is not consulted.
+static bool unitMatches(const TreeHashKey& key, SealedRegion* record, const MemoryRegion& region,
+                        size_t unit, PagemapWindow* window) {
+    const StagedUnit* staged = stagedUnit(region, unit);
+    if (record->mode != INTEGRITY_KEYED_TREE) {
+        return regionChecksum(record, window) == (staged ? staged->checksum : record->checksum);
+    }
+
+    const uint8_t* data;
+    size_t len;
+    treeLeafBounds(reinterpret_cast<void*>(record->address), static_cast<size_t>(record->size),
+                   unit, &data, &len);
+
+    PageState state = leafState(window, data);
+    switch (staged ? staged->kind : sealedLeafKinds(record)[unit]) {
+    case LEAF_ZERO:
+        // An unpopulated anonymous page reads as zero without being touched
+        return (state == PAGE_UNPOPULATED && record->mapping == MAPPING_ANONYMOUS) ||
+               bytesAreZero(data, len);
+    case LEAF_FILE:
+        // Still the file's page, or not loaded and so read from the file
+        // when touched. An anonymous or swapped page is a private copy,
+        // made by the first write.
+        if (state == PAGE_FILE || state == PAGE_UNPOPULATED) return true;
+        if (state != PAGE_UNKNOWN) return false;
+        break;
+    default:
+        // A populated anonymous page only becomes unpopulated by being
+        // discarded, and then reads as zero
+        if (state == PAGE_UNPOPULATED && record->mapping == MAPPING_ANONYMOUS) return false;
+        break;
+    }
+    return treeHashLeaf(key, data, len) == (staged ? staged->digest : sealedLeaves(record)[unit]);
+}
+
+// Whether checking a leaf reads its bytes (see unitMatches)
+static bool leafIsRead(SealedRegion* record, const MemoryRegion& region, size_t unit,
+                       const uint8_t* data, PagemapWindow* window) {
+    PageState state = leafState(window, data);
+    switch (leafKind(record, region, unit)) {
+    case LEAF_ZERO:
+        return !(state == PAGE_UNPOPULATED && record->mapping == MAPPING_ANONYMOUS);
+    case LEAF_FILE:
+        return state == PAGE_UNKNOWN;
+    default:
+        return state != PAGE_UNPOPULATED || record->mapping != MAPPING_ANONYMOUS;
+    }
+}
+
+// Pull a leaf into L1 with the non-temporal hint, which is PLDL1STRM on arm64
+static void prefetchLeaf(const uint8_t* data, size_t len) {
+    for (size_t offset = 0; offset < len; offset += kCacheLine) {
+        __builtin_prefetch(data + offset, 0, 0);
+    }
+}
+
+// Compare one sequence-guarded unit against its baseline, retrying torn reads
+static bool verifyUnit(const TreeHashKey& key, SealedRegion* record,
+                       const MemoryRegion& region, size_t unit, PagemapWindow* window) {
+    std::atomic<uint32_t>& seq = region.seq[unit];
+
+    for (int attempt = 0; attempt < kMaxReadRetries; attempt++) {
+        uint32_t before = seq.load(std::memory_order_acquire);
+        if (before & 1) {
+            // Writer in progress
+            sched_yield();
+            continue;
+        }
+
+        bool matches = unitMatches(key, record, region, unit, window);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq.load(std::memory_order_relaxed) == before) {
+            return matches;
+        }
+    }
+
+    // The game kept writing this unit; it is checked again next time
+    return true;
+}
+
+// One entry of a scan plan: up to kLeavesPerChunk consecutive units of a
+// region (a checksum-mode region is a single unit)
+struct ScanChunk {
+    uintptr_t start;
+    size_t region;
+    size_t first;
+    size_t count;
+};
+
+// Prefetch a leaf if checking it will read it
+static void prefetchUnit(SealedRegion* record, const MemoryRegion& region, size_t unit,
+                         PagemapWindow* window) {
+    const uint8_t* data;
+    size_t len;
+    treeLeafBounds(reinterpret_cast<void*>(record->address), static_cast<size_t>(record->size),
+                   unit, &data, &len);
+    if (leafIsRead(record, region, unit, data, window)) prefetchLeaf(data, len);
+}
+
+// Check one chunk, on arm64 prefetching kPrefetchLeaves ahead of the leaf
+// being hashed
+static bool scanChunk(const TreeHashKey& key, SealedRegion* record, const MemoryRegion& region,
+                      const ScanChunk& chunk, PagemapWindow* window) {
+    size_t end = chunk.first + chunk.count;
+    bool prefetch = kStreamPrefetch && record->mode == INTEGRITY_KEYED_TREE;
+
+    if (prefetch) {
+        for (size_t i = chunk.first; i < std::min(end, chunk.first + kPrefetchLeaves); i++) {
+            prefetchUnit(record, region, i, window);
+        }
+    }
+    for (size_t i = chunk.first; i < end; i++) {
+        if (prefetch && i + kPrefetchLeaves < end) {
+            prefetchUnit(record, region, i + kPrefetchLeaves, window);
+        }
+        if (!verifyUnit(key, record, region, i, window)) return false;
+    }
+    return true;
+}
+
+bool verifyRegions(const SealedTable& table, const std::vector<MemoryRegion*>& regions,
+                   unsigned threads, MemoryRegion** tampered) {
+    const TreeHashKey& key = sealedTableKey(table);
+    *tampered = nullptr;
+
+    // Plan every region's units as chunks in address order, so the scan
+    // sweeps memory once from low to high instead of region by region
+    std::vector<ScanChunk> plan;
+    size_t totalUnits = 0;
+    bool residency = false;
+    for (size_t r = 0; r < regions.size(); r++) {
+        SealedRegion* record = sealedRegion(table, *regions[r]);
+
+        // The unit count comes from the sealed record, not the heap copy
+        bool keyed = record->mode == INTEGRITY_KEYED_TREE;
+        size_t units = keyed ? record->leafCount : 1;
+        if (units != regions[r]->seqCount) {
+            *tampered = regions[r];
+            return false;
+        }
+
+        size_t per = keyed ? kLeavesPerChunk : 1;
+        uintptr_t leafBase = static_cast<uintptr_t>(record->address) / kTreeLeafSize * kTreeLeafSize;
+        for (size_t first = 0; first < units; first += per) {
+            uintptr_t start = keyed ? std::max<uintptr_t>(record->address, leafBase + first * kTreeLeafSize)
+                                    : static_cast<uintptr_t>(record->address);
+            plan.push_back({start, r, first, std::min(per, units - first)});
+        }
+        totalUnits += units;
+        residency |= usesResidency(record);
+    }
+    std::sort(plan.begin(), plan.end(), [](const ScanChunk& a, const ScanChunk& b) {
+        return a.start < b.start;
+    });
+
+    // Workers take chunks in plan order, so they stay close together in
+    // the address space and cheap (zero, file) chunks don't unbalance them
+    int fd = residency ? pagemapOpen() : -1;
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> failed(SIZE_MAX);
+    size_t workers = std::max<size_t>(1, std::min<size_t>(threads, totalUnits / kLeavesPerVerifier));
+    parallelFor(workers, static_cast<unsigned>(workers), 1, [&](size_t, size_t) {
+        // One call per worker
+        PagemapWindow window;
+        pagemapWindowInit(window, fd);
+        while (failed.load(std::memory_order_relaxed) == SIZE_MAX) {
+            size_t c = next.fetch_add(1, std::memory_order_relaxed);
+            if (c >= plan.size()) break;
+
+            const MemoryRegion& region = *regions[plan[c].region];
+            SealedRegion* record = sealedRegion(table, region);
+            if (!scanChunk(key, record, region, plan[c], usesResidency(record) ? &window : nullptr)) {
+                failed.store(plan[c].region, std::memory_order_relaxed);
+            }
+        }
+    });
+    pagemapClose(fd);
+
+    size_t index = failed.load();
+    if (index == SIZE_MAX) return true;
+    *tampered = regions[index];
+    return false;
+}
+
+bool verifyRegion(const SealedTable& table, const MemoryRegion& region, unsigned threads) {
+    std::vector<MemoryRegion*> regions(1, const_cast<MemoryRegion*>(&region));
+    MemoryRegion* tampered;
+    return verifyRegions(table, regions, threads, &tampered);
+}
+
+bool verifyRegionSnapshot(const SealedTable& table, const MemoryRegion& region) {
+    SealedRegion* record = sealedRegion(table, region);
+    const TreeHashKey& key = sealedTableKey(table);
+
+    size_t units = record->mode == INTEGRITY_KEYED_TREE ? record->leafCount : 1;
+    if (units != region.seqCount) return false;
+
+    // The child's own pagemap: fork copies the page tables of anonymous
+    // mappings, so residency matches the parent's at fork time. File pages
+    // may be left to fault in the child; they read the same file data.
+    PagemapWindow window;
+    pagemapWindowInit(window, openResidency(record));
+
+    // Nothing moves in a snapshot: a unit caught mid-write stays odd and is
+    // left to the next check
+    bool intact = true;
+    for (size_t i = 0; i < units && intact; i++) {
+        if (region.seq[i].load(std::memory_order_relaxed) & 1) continue;
+        intact = unitMatches(key, record, region, i, &window);
+    }
+    pagemapClose(window.fd);
+    return intact;
+}
+
+// Identifies unit holders. Cached: glibc's gettid() is a system call each
+// time (bionic's reads a cached value).
+static int32_t threadId() {
+    static thread_local int32_t tid = static_cast<int32_t>(gettid());
+    return tid;
+}
+
+static bool rangeInRegion(const MemoryRegion& region, size_t offset, size_t size) {
+    return region.valid && size != 0 && offset <= region.size && size <= region.size - offset;
+}
+
+static void unlockUnit(MemoryRegion& region, size_t unit) {
+    region.holder[unit].store(0, std::memory_order_relaxed);
+    region.seq[unit].fetch_add(1, std::memory_order_release);
+}
+
+// Make the counters odd, in ascending order so overlapping writers can't
+// deadlock. Fails, holding nothing, on a unit this thread already holds.
+static bool lockUnits(MemoryRegion& region, size_t first, size_t last) {
+    int32_t self = threadId();
+    for (size_t i = first; i <= last; i++) {
+        std::atomic<uint32_t>& seq = region.seq[i];
+        uint32_t current = seq.load(std::memory_order_relaxed);
+        for (;;) {
+            if (current & 1) {
+                // A holder whose region is being destroyed may never release
+                if (region.holder[i].load(std::memory_order_relaxed) == self ||
+                    region.retired.load(std::memory_order_relaxed)) {
+                    while (i-- > first) unlockUnit(region, i);
+                    return false;
+                }
+                sched_yield();
+                current = seq.load(std::memory_order_relaxed);
+            } else if (seq.compare_exchange_weak(current, current + 1,
+                                                 std::memory_order_acquire,
+                                                 std::memory_order_relaxed)) {
+                region.holder[i].store(self, std::memory_order_relaxed);
+                break;
+            }
+        }
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    return true;
+}
+
+// Whether this thread holds every unit in [first, last]
+static bool unitsHeld(const MemoryRegion& region, size_t first, size_t last) {
+    int32_t self = threadId();
+    for (size_t i = first; i <= last; i++) {
+        if (!(region.seq[i].load(std::memory_order_relaxed) & 1) ||
+            region.holder[i].load(std::memory_order_relaxed) != self) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Release units this thread holds; false, releasing nothing, otherwise
+static bool unlockUnits(MemoryRegion& region, size_t first, size_t last) {
+    if (!unitsHeld(region, first, last)) return false;
+    for (size_t i = first; i <= last; i++) {
+        unlockUnit(region, i);
+    }
+    return true;
+}
+
+// Check held units against the baseline. The caller need not hold the
+// lock the table is relocated under.
+static bool heldUnitsMatch(SealedTable& table, const MemoryRegion& region, size_t first, size_t last) {
+    SealedPin pin(table);
+    SealedRegion* record = sealedRegion(table, region);
+    const TreeHashKey& key = sealedTableKey(table);
+    for (size_t i = first; i <= last; i++) {
+        if (!unitMatches(key, record, region, i, nullptr)) return false;
+    }
+    return true;
+}
+
+bool beginRegionWrite(SealedTable& table, MemoryRegion& region, size_t offset, size_t size) {
+    if (!rangeInRegion(region, offset, size)) return false;
+
+    size_t first, last;
+    seqRange(region, offset, size, &first, &last);
+    if (!lockUnits(region, first, last)) return false;
+
+    // Re-sealing at the end would otherwise adopt an edit made before the
+    // write; left as it is, the next check reports it
+    if (!heldUnitsMatch(table, region, first, last)) {
+        unlockUnits(region, first, last);
+        return false;
+    }
+    return true;
+}
+
+bool endRegionWrite(SealedTable& table, MemoryRegion& region, size_t offset, size_t size) {
+    if (!rangeInRegion(region, offset, size)) return false;
+
+    size_t first, last;
+    seqRange(region, offset, size, &first, &last);
+    if (!unitsHeld(region, first, last)) return false;
+
+    {
+        // Only the touched leaves are re-hashed, into the staging area; the
+        // sealed table stays sealed until the next check merges them
+        SealedPin pin(table);
+        SealedRegion* record = sealedRegion(table, region);
+        if (region.mode == INTEGRITY_KEYED_TREE) {
+            for (size_t i = first; i <= last; i++) {
+                // Just written, so populated; no need to ask pagemap
+                StagedUnit& staged = region.staged[i];
+                sealLeaf(sealedTableKey(table), record, i, nullptr, &staged.digest, &staged.kind);
+                staged.pending.store(true, std::memory_order_relaxed);
+            }
+        } else {
+            int fd = openResidency(record);
+            PagemapWindow window;
+            pagemapWindowInit(window, fd);
+            region.staged[0].checksum = regionChecksum(record, &window);
+            region.staged[0].pending.store(true, std::memory_order_relaxed);
+            pagemapClose(fd);
+        }
+    }
+    region.hasStaged.store(true, std::memory_order_relaxed);
+
+    return unlockUnits(region, first, last);
+}
+
+bool regionWritesStaged(const MemoryRegion& region) {
+    return region.valid && region.hasStaged.load(std::memory_order_relaxed);
+}
+
+void mergeRegionWrites(SealedTable& table, MemoryRegion& region) {
+    if (!region.valid || !region.hasStaged.exchange(false, std::memory_order_relaxed)) return;
+
+    SealedRegion* record = sealedRegion(table, region);
+    int32_t self = threadId();
+    for (size_t i = 0; i < region.seqCount; i++) {
+        if (!region.staged[i].pending.load(std::memory_order_relaxed)) continue;
+
+        // Hold the unit so no write restages it mid-merge
+        uint32_t current = region.seq[i].load(std::memory_order_relaxed);
+        if ((current & 1) || !region.seq[i].compare_exchange_strong(current, current + 1,
+                                                                   std::memory_order_acquire,
+                                                                   std::memory_order_relaxed)) {
+            region.hasStaged.store(true, std::memory_order_relaxed);
+            continue;
+        }
+        region.holder[i].store(self, std::memory_order_relaxed);
+
+        StagedUnit& staged = region.staged[i];
+        if (record->mode == INTEGRITY_KEYED_TREE) {
+            sealedLeaves(record)[i] = staged.digest;
+            sealedLeafKinds(record)[i] = staged.kind;
+        } else {
+            record->checksum = staged.checksum;
+        }
+        staged.pending.store(false, std::memory_order_relaxed);
+        unlockUnit(region, i);
+    }
+}
+
+bool regionWritesStuck(MemoryRegion& region) {
+    if (!region.valid) return false;
+
+    bool stuck = false;
+    for (size_t i = 0; i < region.seqCount; i++) {
+        uint32_t current = region.seq[i].load(std::memory_order_relaxed);
+        if (!(current & 1)) {
+            region.heldChecks[i] = 0;
+        } else if (region.heldChecks[i] > 0 && region.heldSeq[i] == current) {
+            // Still the same write: the counter moves on every begin and end
+            if (region.heldChecks[i] < kMaxHeldChecks) region.heldChecks[i]++;
+            stuck |= region.heldChecks[i] >= kMaxHeldChecks;
+        } else {
+            region.heldSeq[i] = current;
+            region.heldChecks[i] = 1;
+        }
+    }
+    return stuck;
+}
+
+bool beginRegionRead(SealedTable& table, MemoryRegion& region, size_t offset, size_t size) {
+    if (!rangeInRegion(region, offset, size)) return false;
+
+    size_t first, last;
+    seqRange(region, offset, size, &first, &last);
+
+    // Holding the counters keeps writers out between the check and the copy
+    if (!lockUnits(region, first, last)) return false;
+    if (!heldUnitsMatch(table, region, first, last)) {
+        unlockUnits(region, first, last);
+        return false;
+    }
+    return true;
+}
+
+void endRegionRead(MemoryRegion& region, size_t offset, size_t size) {
+    if (!rangeInRegion(region, offset, size)) return;
+
+    size_t first, last;
+    seqRange(region, offset, size, &first, &last);
+    unlockUnits(region, first, last);
+}
+
+bool readRegion(SealedTable& table, MemoryRegion& region, size_t offset,
+                void* out, size_t size) {
+    if (!beginRegionRead(table, region, offset, size)) return false;
+    memcpy(out, static_cast<uint8_t*>(region.address) + offset, size);
+    endRegionRead(region, offset, size);
+    return true;
+}
+
+bool writeRegion(SealedTable& table, MemoryRegion& region, size_t offset,
+                 const void* data, size_t size) {
+    if (!beginRegionWrite(table, region, offset, size)) return false;
+    memcpy(static_cast<uint8_t*>(region.address) + offset, data, size);
+    return endRegionWrite(table, region, offset, size);
+}
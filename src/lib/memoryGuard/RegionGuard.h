@@ -0,0 +1,137 @@
+#ifndef STFU_REGION_GUARD_H
+#define STFU_REGION_GUARD_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "KeyedTreeHash.h"
+#include "PageResidency.h"
+#include "SealedTable.h"
+
+// Region integrity modes (mirrors GameGuardianShield.INTEGRITY_MODE_*)
+enum IntegrityMode {
+    INTEGRITY_CHECKSUM = 0,   // Unkeyed djb2, kept for compatibility
+    INTEGRITY_KEYED_TREE = 1, // Session-keyed tree hash
+};
+
+// Baseline of a unit written since the last merge into the sealed table
+struct StagedUnit {
+    TreeDigest digest;
+    uint32_t checksum; // Checksum mode
+    uint8_t kind;
+    std::atomic<bool> pending{false};
+};
+
+// Struct to track protected memory regions.
+//
+// The baseline (address, size, mode, checksum and leaf digests) lives in a
+// record in the sealed table; the verifier trusts only that copy. The fields
+// here are the writer-side view plus the sequence counters, which change too
+// often to live in read-only pages.
+//
+// Leaves that are all zero are flagged in the baseline instead of hashed.
+// In a private anonymous mapping a page that was never populated reads as
+// zero, so such pages are neither read at seal time nor faulted in by
+// later checks (see PageResidency.h); zero-flagged leaves on populated
+// pages are compared against zero, which is cheaper than hashing.
+//
+// In a private file mapping, leaves whose pages are still page cache are
+// not hashed at all: a write would have replaced the page with an
+// anonymous copy, so a page that is no longer file-backed is reported as
+// tampered. Their digests are still sealed, for when pagemap is not
+// readable.
+//
+// Every leaf (or the whole region in checksum mode) has a sequence counter.
+// Writers make it odd for the duration of a write and re-hash the leaf before
+// making it even again; the verifier only retries leaves whose counter moved
+// while it was hashing them, so verification never blocks the game.
+//
+// That makes an open write an exemption from checking, so writes are
+// policed: a write starts only on leaves that still match the baseline,
+// only the thread that started it can end it, and a counter left odd at
+// the same value across several checks is reported (regionWritesStuck).
+//
+// Ending a write does not unseal the table: the new leaf baselines go to
+// the region's staging area, which checks prefer while a leaf is staged,
+// and the next check folds them into the sealed table in one batch
+// (mergeRegionWrites). A write costs a re-hash of its leaves and no
+// syscall; staged baselines sit in writable memory until that check.
+struct MemoryRegion {
+    void* address;
+    size_t size;
+    int mode;
+    size_t record;
+    std::unique_ptr<std::atomic<uint32_t>[]> seq;
+    std::unique_ptr<std::atomic<int32_t>[]> holder; // Thread holding each odd counter
+    std::unique_ptr<uint32_t[]> heldSeq;            // Odd counter seen by the last check
+    std::unique_ptr<uint8_t[]> heldChecks;          // Checks in a row that saw it
+    size_t seqCount;
+    bool valid;
+    bool owned;          // Block mapped by the shield itself, unmapped on destroy
+    MappingKind mapping; // Set before sealing; decides how residency is used
+    std::atomic<bool> retired{false}; // Being destroyed: writes stop waiting for units
+    std::unique_ptr<StagedUnit[]> staged; // Per unit, guarded by its sequence counter
+    std::atomic<bool> hasStaged{false};   // Some unit may be staged
+};
+
+// Calculate memory region checksum
+uint32_t calculateChecksum(void* addr, size_t size);
+
+// Set up sequence counters and record the baseline for a new region.
+// Must be called inside a sealed table batch.
+bool sealRegion(SealedTable& table, MemoryRegion& region, unsigned threads);
+
+// Re-hash a region against its sealed baseline; false if it was tampered with
+bool verifyRegion(const SealedTable& table, const MemoryRegion& region, unsigned threads);
+
+// Check several regions in one pass. Their leaves are planned as L2-sized
+// chunks in address order, and on arm64 read through streaming prefetches,
+// to keep the scan from flushing the game's working set out of the caches.
+// Returns false and sets `tampered` to the first region found modified.
+bool verifyRegions(const SealedTable& table, const std::vector<MemoryRegion*>& regions,
+                   unsigned threads, MemoryRegion** tampered);
+
+// Single-threaded check of a frozen copy of the process (a forked child);
+// allocation-free, so it is safe after fork in a multithreaded process
+bool verifyRegionSnapshot(const SealedTable& table, const MemoryRegion& region);
+
+// Bracket a legitimate write to [offset, offset + size) of a region.
+// Writers to overlapping leaves are serialized by the sequence counters.
+// Begin fails if the range is bad, overlaps a write this thread already
+// has open, or no longer matches the baseline (an edit made outside a
+// write must not become the new baseline). End re-seals only a range this
+// thread began; anything else is refused and returns false.
+bool beginRegionWrite(SealedTable& table, MemoryRegion& region, size_t offset, size_t size);
+bool endRegionWrite(SealedTable& table, MemoryRegion& region, size_t offset, size_t size);
+
+// Fold baselines staged by ended writes into the sealed table. Must be
+// called inside a sealed table batch, serialized with checks; units held
+// by a write at the time stay staged for the next call.
+bool regionWritesStaged(const MemoryRegion& region);
+void mergeRegionWrites(SealedTable& table, MemoryRegion& region);
+
+// True once a leaf has been held by the same open write for
+// kMaxHeldChecks checks in a row. Call once per check, serialized with
+// other checks.
+constexpr int kMaxHeldChecks = 3;
+bool regionWritesStuck(MemoryRegion& region);
+
+// Check the leaves spanning [offset, offset + size) against the baseline and
+// keep writers out of them until endRegionRead, so the range can be copied
+// out as checked. Returns false, holding nothing, if they don't match or the
+// range is bad. Safe against a concurrent sealedTableRelocate.
+bool beginRegionRead(SealedTable& table, MemoryRegion& region, size_t offset, size_t size);
+void endRegionRead(MemoryRegion& region, size_t offset, size_t size);
+
+// beginRegionRead, copy, endRegionRead
+bool readRegion(SealedTable& table, MemoryRegion& region, size_t offset,
+                void* out, size_t size);
+
+// Write a range and fold it into the baseline in one step
+bool writeRegion(SealedTable& table, MemoryRegion& region, size_t offset,
+                 const void* data, size_t size);
+
+#endif // STFU_REGION_GUARD_H
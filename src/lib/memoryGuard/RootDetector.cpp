@@ -0,0 +1,199 @@
+#include "RootDetector.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/stat.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "ShieldLog.h"
+
+const char* const kDefaultRootPaths[] = {
+    "/system/bin/su",
+    "/system/xbin/su",
+    "/system/sbin/su",
+    "/sbin/su",
+    "/su/bin/su",
+    "/system/su",
+    "/system/bin/.ext/.su",
+    "/system/usr/we-need-root/su",
+    "/vendor/bin/su",
+    "/data/local/su",
+    "/data/local/bin/su",
+    "/data/local/xbin/su",
+    "/cache/su",
+    "/dev/su",
+    "/system/app/Superuser.apk",
+    "/system/xbin/daemonsu",
+    "/system/etc/init.d/99SuperSUDaemon",
+    "/sbin/magisk",
+    "/debug_ramdisk/magisk",
+    "/data/adb/magisk",
+    "/data/adb/ksud",
+    "/data/adb/apd",
+};
+const size_t kDefaultRootPathCount = sizeof(kDefaultRootPaths) / sizeof(kDefaultRootPaths[0]);
+
+// Mount sources and points that only root managers create
+static const char* const kRootMountMarkers[] = {
+    "magisk",
+    "/debug_ramdisk",
+    "KSU",
+    "APatch",
+};
+
+// Partitions that are read-only on every stock build
+static const char* const kReadOnlyMounts[] = {
+    "/system",
+    "/vendor",
+    "/product",
+};
+
+// Where su is bind-mounted to end up on PATH
+static const char* const kBinMounts[] = {
+    "/system/bin",
+    "/system/xbin",
+};
+
+// Process domains of root managers and su sessions
+static const char* const kRootDomains[] = {
+    "magisk",
+    ":su:",
+    "ksu",
+};
+
+// statx where the kernel has it (4.11+), fstatat otherwise
+static bool statMode(const char* path, uint32_t* mode, uint32_t* uid) {
+#ifdef __NR_statx
+    struct statx sx;
+    if (syscall(__NR_statx, AT_FDCWD, path, AT_STATX_DONT_SYNC, STATX_TYPE | STATX_MODE | STATX_UID, &sx) == 0) {
+        *mode = sx.stx_mode;
+        *uid = sx.stx_uid;
+        return true;
+    }
+    if (errno != ENOSYS) return false;
+#endif
+    struct stat st;
+    if (fstatat(AT_FDCWD, path, &st, 0) != 0) return false;
+    *mode = st.st_mode;
+    *uid = st.st_uid;
+    return true;
+}
+
+uint32_t rootProbePaths(const char* const* paths, size_t count) {
+    // Nearly every probe misses, so the cheap access check runs first and
+    // only hits are looked at in detail
+    uint32_t signals = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (faccessat(AT_FDCWD, paths[i], F_OK, AT_EACCESS) != 0) continue;
+        signals |= ROOT_SIGNAL_PATH;
+        LOGW("Root path present: %s", paths[i]);
+
+        uint32_t mode, uid;
+        if (statMode(paths[i], &mode, &uid) && S_ISREG(mode) && (mode & S_ISUID) && uid == 0) {
+            signals |= ROOT_SIGNAL_SETUID;
+        }
+    }
+    return signals;
+}
+
+static bool fieldIs(const char* field, size_t length, const char* value) {
+    return strlen(value) == length && memcmp(field, value, length) == 0;
+}
+
+static bool fieldHas(const char* field, size_t length, const char* marker) {
+    return memmem(field, length, marker, strlen(marker)) != nullptr;
+}
+
+// One mountinfo line:
+//   id parent major:minor root mountpoint options [optional...] - fstype source superoptions
+static uint32_t scanMountLine(const char* line, size_t length) {
+    const char* fields[16];
+    size_t sizes[16];
+    size_t count = 0;
+    size_t separator = 0;
+    for (size_t i = 0; i < length && count < 16;) {
+        while (i < length && line[i] == ' ') i++;
+        if (i >= length) break;
+        size_t start = i;
+        while (i < length && line[i] != ' ') i++;
+        fields[count] = line + start;
+        sizes[count] = i - start;
+        if (separator == 0 && sizes[count] == 1 && fields[count][0] == '-') separator = count;
+        count++;
+    }
+    if (separator < 6 || separator + 2 >= count) return 0;
+
+    const char* mountPoint = fields[4];
+    size_t mountPointSize = sizes[4];
+    const char* options = fields[5];
+    const char* fsType = fields[separator + 1];
+    size_t fsTypeSize = sizes[separator + 1];
+    const char* source = fields[separator + 2];
+    size_t sourceSize = sizes[separator + 2];
+
+    for (const char* marker : kRootMountMarkers) {
+        if (fieldHas(source, sourceSize, marker) || fieldHas(mountPoint, mountPointSize, marker)) {
+            return ROOT_SIGNAL_MOUNT;
+        }
+    }
+    for (const char* partition : kReadOnlyMounts) {
+        if (fieldIs(mountPoint, mountPointSize, partition) && sizes[5] >= 2 && memcmp(options, "rw", 2) == 0) {
+            return ROOT_SIGNAL_MOUNT;
+        }
+    }
+    for (const char* bin : kBinMounts) {
+        if (fieldIs(mountPoint, mountPointSize, bin) &&
+            (fieldIs(fsType, fsTypeSize, "tmpfs") || fieldIs(fsType, fsTypeSize, "overlay"))) {
+            return ROOT_SIGNAL_MOUNT;
+        }
+    }
+    return 0;
+}
+
+uint32_t rootScanMountinfo(const char* data, size_t length) {
+    const char* end = data + length;
+    for (const char* line = data; line < end;) {
+        const char* next = static_cast<const char*>(memchr(line, '\n', end - line));
+        if (!next) next = end;
+        if (scanMountLine(line, next - line)) {
+            LOGW("Root mount: %.*s", static_cast<int>(next - line), line);
+            return ROOT_SIGNAL_MOUNT;
+        }
+        line = next + 1;
+    }
+    return 0;
+}
+
+static ssize_t readSmallFile(const char* path, char* buffer, size_t size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    ssize_t length = read(fd, buffer, size - 1);
+    close(fd);
+    if (length >= 0) buffer[length] = '\0';
+    return length;
+}
+
+uint32_t rootCheckSelinux() {
+    uint32_t signals = 0;
+    char buffer[256];
+
+    // Apps may not read this on recent releases; unreadable proves nothing
+    if (readSmallFile("/sys/fs/selinux/enforce", buffer, sizeof(buffer)) > 0 && buffer[0] == '0') {
+        signals |= ROOT_SIGNAL_SELINUX_PERMISSIVE;
+    }
+
+    ssize_t length = readSmallFile("/proc/self/attr/current", buffer, sizeof(buffer));
+    if (length > 0) {
+        for (const char* domain : kRootDomains) {
+            if (memmem(buffer, length, domain, strlen(domain))) {
+                LOGW("Running in root domain: %s", buffer);
+                signals |= ROOT_SIGNAL_SELINUX_CONTEXT;
+                break;
+            }
+        }
+    }
+    return signals;
+}
@@ -0,0 +1,40 @@
+#ifndef STFU_ROOT_DETECTOR_H
+#define STFU_ROOT_DETECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Root detection from syscalls alone: no `which su`, no process spawns.
+//
+// Three independent kinds of evidence, each reported as its own bit:
+//  - Paths: one faccessat(F_OK) pass over the whole probe table, then statx
+//    only on the paths that were found. A set-uid root binary is reported
+//    separately, since nothing stock ships one.
+//  - Mounts: /proc/self/mountinfo showing system partitions mounted
+//    read-write, su bind-mounted over /system/bin or /system/xbin, or mount
+//    sources and points belonging to Magisk, KernelSU or APatch.
+//  - SELinux: enforcement switched off, or this process running in a root
+//    manager's domain instead of an app domain.
+// Root hiders remove some of this evidence from app processes, so any one
+// bit is a signal, not proof.
+
+enum RootSignal : uint32_t {
+    ROOT_SIGNAL_PATH = 1u << 0,              // A probe path exists
+    ROOT_SIGNAL_SETUID = 1u << 1,            // ...and is a set-uid root file
+    ROOT_SIGNAL_MOUNT = 1u << 2,             // Suspicious entry in mountinfo
+    ROOT_SIGNAL_SELINUX_PERMISSIVE = 1u << 3,
+    ROOT_SIGNAL_SELINUX_CONTEXT = 1u << 4,   // Process domain of a root manager
+};
+
+// Default probe table: su binaries and root manager files
+extern const char* const kDefaultRootPaths[];
+extern const size_t kDefaultRootPathCount;
+
+uint32_t rootProbePaths(const char* const* paths, size_t count);
+
+// Scan the contents of /proc/self/mountinfo
+uint32_t rootScanMountinfo(const char* data, size_t length);
+
+uint32_t rootCheckSelinux();
+
+#endif // STFU_ROOT_DETECTOR_H
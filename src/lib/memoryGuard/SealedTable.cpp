@@ -0,0 +1,159 @@
+#include "SealedTable.h"
+
+#include <cstring>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "ShieldLog.h"
+
+// Records are kept 16-byte aligned so atomics and digests can live in them
+constexpr size_t kRecordAlign = 16;
+
+struct SealedHeader {
+    TreeHashKey sessionKey;
+};
+
+static size_t pageSize() {
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+static size_t roundUp(size_t value, size_t align) {
+    return (value + align - 1) / align * align;
+}
+
+static void protect(SealedTable& table, uint8_t* base, size_t bytes, int prot) {
+    if (mprotect(base, bytes, prot) != 0) {
+        LOGE("Sealed table mprotect failed");
+    }
+    table.protectCalls++;
+}
+
+bool sealedTableCreate(SealedTable& table, size_t reserveBytes, const TreeHashKey& key) {
+    std::lock_guard<std::mutex> lock(table.mutex);
+    if (table.base) return true;
+
+    size_t reserved = roundUp(reserveBytes, pageSize());
+    void* base = mmap(nullptr, reserved, PROT_NONE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        LOGE("Failed to reserve sealed table");
+        return false;
+    }
+
+    table.base = static_cast<uint8_t*>(base);
+    table.reserved = reserved;
+    table.committed = roundUp(sizeof(SealedHeader), pageSize());
+    table.used = roundUp(sizeof(SealedHeader), kRecordAlign);
+
+    // A batch opened before creation keeps the table writable until it ends
+    protect(table, table.base, table.committed, PROT_READ | PROT_WRITE);
+    sealedTableAt<SealedHeader>(table, 0)->sessionKey = key;
+    if (table.depth == 0) {
+        protect(table, table.base, table.committed, PROT_READ);
+    }
+    return true;
+}
+
+void sealedTableDestroy(SealedTable& table) {
+    std::lock_guard<std::mutex> lock(table.mutex);
+    if (!table.base) return;
+
+    munmap(table.base, table.reserved);
+    table.base = nullptr;
+    table.reserved = 0;
+    table.committed = 0;
+    table.used = 0;
+}
+
+void sealedTableBeginBatch(SealedTable& table) {
+    std::lock_guard<std::mutex> lock(table.mutex);
+    if (table.depth++ == 0 && table.base) {
+        protect(table, table.base, table.committed, PROT_READ | PROT_WRITE);
+    }
+}
+
+void sealedTableEndBatch(SealedTable& table) {
+    std::lock_guard<std::mutex> lock(table.mutex);
+    if (table.depth == 0) return;
+    if (--table.depth == 0 && table.base) {
+        protect(table, table.base, table.committed, PROT_READ);
+    }
+}
+
+size_t sealedTableAllocate(SealedTable& table, size_t bytes) {
+    std::lock_guard<std::mutex> lock(table.mutex);
+    if (!table.base || table.depth == 0) {
+        LOGE("Sealed table allocation outside a batch");
+        return 0;
+    }
+
+    bytes = roundUp(bytes, kRecordAlign);
+    if (bytes > table.reserved - table.used) {
+        LOGE("Sealed table is full");
+        return 0;
+    }
+
+    // Grow in place: the reservation never moves while a batch is open
+    size_t needed = roundUp(table.used + bytes, pageSize());
+    if (needed > table.committed) {
+        protect(table, table.base + table.committed, needed - table.committed,
+                PROT_READ | PROT_WRITE);
+        table.committed = needed;
+    }
+
+    size_t offset = table.used;
+    table.used += bytes;
+    return offset;
+}
+
+// Pins and relocation each announce themselves before checking for the
+// other (both sequentially consistent), so at most one side goes ahead
+void sealedTablePin(SealedTable& table) {
+    for (;;) {
+        table.pins.fetch_add(1);
+        if (!table.relocating.load()) return;
+        table.pins.fetch_sub(1);
+        while (table.relocating.load()) {
+            sched_yield();
+        }
+    }
+}
+
+void sealedTableUnpin(SealedTable& table) {
+    table.pins.fetch_sub(1, std::memory_order_release);
+}
+
+bool sealedTableRelocate(SealedTable& table, uintptr_t hint) {
+    std::lock_guard<std::mutex> lock(table.mutex);
+    if (!table.base || table.depth > 0) return false;
+
+    table.relocating.store(true);
+    if (table.pins.load() > 0) {
+        table.relocating.store(false);
+        return false;
+    }
+
+    void* fresh = mmap(reinterpret_cast<void*>(hint), table.reserved, PROT_NONE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (fresh == MAP_FAILED) {
+        LOGW("Sealed table relocation failed");
+        table.relocating.store(false);
+        return false;
+    }
+
+    uint8_t* base = static_cast<uint8_t*>(fresh);
+    protect(table, base, table.committed, PROT_READ | PROT_WRITE);
+    memcpy(base, table.base, table.used);
+    protect(table, base, table.committed, PROT_READ);
+
+    munmap(table.base, table.reserved);
+    table.base = base;
+    table.relocating.store(false);
+    return true;
+}
+
+const TreeHashKey& sealedTableKey(const SealedTable& table) {
+    return sealedTableAt<SealedHeader>(table, 0)->sessionKey;
+}
@@ -0,0 +1,78 @@
+#ifndef STFU_SEALED_TABLE_H
+#define STFU_SEALED_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "KeyedTreeHash.h"
+
+// Read-only table holding the session key, region metadata and baselines.
+//
+// The table lives in its own mmap'd reservation and stays PROT_READ except
+// while a batch is open; nested and concurrent batches share one
+// unseal/seal pair. Records are addressed by offset so the whole table can
+// be moved to a fresh mapping without fixing up references.
+struct SealedTable {
+    uint8_t* base = nullptr;
+    size_t reserved = 0;  // Bytes of address space reserved
+    size_t committed = 0; // Bytes accessible (read-only unless unsealed)
+    size_t used = 0;      // Bytes handed out, header included
+    int depth = 0;        // Open batches
+    std::atomic<int> pins{0};            // Readers outside the owner's lock (see SealedPin)
+    std::atomic<bool> relocating{false}; // Set while a relocation moves the table
+    uint64_t protectCalls = 0;
+    std::mutex mutex;
+};
+
+bool sealedTableCreate(SealedTable& table, size_t reserveBytes, const TreeHashKey& key);
+void sealedTableDestroy(SealedTable& table);
+
+// Unseal for a batch of updates; pairs must balance
+void sealedTableBeginBatch(SealedTable& table);
+void sealedTableEndBatch(SealedTable& table);
+
+// Reserve zeroed bytes inside an open batch. Returns 0 when the table is full.
+size_t sealedTableAllocate(SealedTable& table, size_t bytes);
+
+// Keep the table where it is without unsealing it, for readers that don't
+// hold the lock its owner relocates under; pairs must balance. Lock-free,
+// since game threads pin on every region write: a pin waits only while a
+// relocation is copying the table.
+void sealedTablePin(SealedTable& table);
+void sealedTableUnpin(SealedTable& table);
+
+// Move the table to a new mapping. Skipped while a batch is open or the
+// table is pinned; callers must also exclude other readers that hold
+// pointers into the table.
+bool sealedTableRelocate(SealedTable& table, uintptr_t hint);
+
+const TreeHashKey& sealedTableKey(const SealedTable& table);
+
+template <typename T>
+T* sealedTableAt(const SealedTable& table, size_t offset) {
+    return reinterpret_cast<T*>(table.base + offset);
+}
+
+// Scoped batch
+struct SealedBatch {
+    explicit SealedBatch(SealedTable& t) : table(t) { sealedTableBeginBatch(table); }
+    ~SealedBatch() { sealedTableEndBatch(table); }
+    SealedBatch(const SealedBatch&) = delete;
+    SealedBatch& operator=(const SealedBatch&) = delete;
+
+    SealedTable& table;
+};
+
+// Scoped pin
+struct SealedPin {
+    explicit SealedPin(SealedTable& t) : table(t) { sealedTablePin(table); }
+    ~SealedPin() { sealedTableUnpin(table); }
+    SealedPin(const SealedPin&) = delete;
+    SealedPin& operator=(const SealedPin&) = delete;
+
+    SealedTable& table;
+};
+
+#endif // STFU_SEALED_TABLE_H
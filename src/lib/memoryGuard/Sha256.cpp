@@ -0,0 +1,481 @@
+#include "Sha256.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+constexpr size_t kBlockSize = 64;
+
+// Messages per compress call for the widest backend
+constexpr size_t kMaxLanes = 4;
+
+// Compress one block into each of `lanes` states
+typedef void (*CompressFn)(uint32_t (*states)[8], const uint8_t* const* blocks, size_t lanes);
+
+alignas(16) static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const uint32_t INITIAL_STATE[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+static inline uint32_t loadBigEndian(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Four rounds: the low two message words go through the first SHA256RNDS2,
+// the high two through the second
+__attribute__((target("sha,sse4.1")))
+static inline void shaniQuad(__m128i& abef, __m128i& cdgh, __m128i msg, size_t round) {
+    msg = _mm_add_epi32(msg, _mm_load_si128(reinterpret_cast<const __m128i*>(K + round)));
+    cdgh = _mm_sha256rnds2_epu32(cdgh, abef, msg);
+    abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(msg, 0x0E));
+}
+
+// Next four schedule words from the previous sixteen
+__attribute__((target("sha,sse4.1")))
+static inline __m128i shaniSchedule(__m128i w0, __m128i w1, __m128i w2, __m128i w3) {
+    __m128i sum = _mm_add_epi32(_mm_sha256msg1_epu32(w0, w1), _mm_alignr_epi8(w3, w2, 4));
+    return _mm_sha256msg2_epu32(sum, w3);
+}
+
+// SHA-NI keeps the state as (A,B,E,F) and (C,D,G,H)
+struct ShaniStream {
+    __m128i abef, cdgh;
+    __m128i m0, m1, m2, m3;
+};
+
+__attribute__((target("sha,sse4.1")))
+static inline void shaniLoad(ShaniStream& s, const uint32_t state[8], const uint8_t* block) {
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+    __m128i dcba = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xB1);
+    __m128i efgh = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1B);
+    s.abef = _mm_alignr_epi8(dcba, efgh, 8);
+    s.cdgh = _mm_blend_epi16(efgh, dcba, 0xF0);
+
+    const __m128i* words = reinterpret_cast<const __m128i*>(block);
+    s.m0 = _mm_shuffle_epi8(_mm_loadu_si128(words + 0), byteSwap);
+    s.m1 = _mm_shuffle_epi8(_mm_loadu_si128(words + 1), byteSwap);
+    s.m2 = _mm_shuffle_epi8(_mm_loadu_si128(words + 2), byteSwap);
+    s.m3 = _mm_shuffle_epi8(_mm_loadu_si128(words + 3), byteSwap);
+}
+
+__attribute__((target("sha,sse4.1")))
+static inline void shaniStore(const ShaniStream& s, __m128i abef0, __m128i cdgh0, uint32_t state[8]) {
+    __m128i abef = _mm_add_epi32(s.abef, abef0);
+    __m128i cdgh = _mm_add_epi32(s.cdgh, cdgh0);
+    __m128i feba = _mm_shuffle_epi32(abef, 0x1B);
+    __m128i dchg = _mm_shuffle_epi32(cdgh, 0xB1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_blend_epi16(feba, dchg, 0xF0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), _mm_alignr_epi8(dchg, feba, 8));
+}
+
+__attribute__((target("sha,sse4.1")))
+static void shaniCompressOne(uint32_t state[8], const uint8_t* block) {
+    ShaniStream a;
+    shaniLoad(a, state, block);
+    const __m128i abef = a.abef, cdgh = a.cdgh;
+
+    shaniQuad(a.abef, a.cdgh, a.m0, 0);
+    shaniQuad(a.abef, a.cdgh, a.m1, 4);
+    shaniQuad(a.abef, a.cdgh, a.m2, 8);
+    shaniQuad(a.abef, a.cdgh, a.m3, 12);
+    for (size_t r = 16; r < 64; r += 16) {
+        a.m0 = shaniSchedule(a.m0, a.m1, a.m2, a.m3);
+        shaniQuad(a.abef, a.cdgh, a.m0, r);
+        a.m1 = shaniSchedule(a.m1, a.m2, a.m3, a.m0);
+        shaniQuad(a.abef, a.cdgh, a.m1, r + 4);
+        a.m2 = shaniSchedule(a.m2, a.m3, a.m0, a.m1);
+        shaniQuad(a.abef, a.cdgh, a.m2, r + 8);
+        a.m3 = shaniSchedule(a.m3, a.m0, a.m1, a.m2);
+        shaniQuad(a.abef, a.cdgh, a.m3, r + 12);
+    }
+    shaniStore(a, abef, cdgh, state);
+}
+
+__attribute__((target("sha,sse4.1")))
+static void shaniCompress(uint32_t (*states)[8], const uint8_t* const* blocks, size_t lanes) {
+    if (lanes == 1) {
+        shaniCompressOne(states[0], blocks[0]);
+        return;
+    }
+
+    ShaniStream a, b;
+    shaniLoad(a, states[0], blocks[0]);
+    shaniLoad(b, states[1], blocks[1]);
+    const __m128i abefA = a.abef, cdghA = a.cdgh;
+    const __m128i abefB = b.abef, cdghB = b.cdgh;
+
+    shaniQuad(a.abef, a.cdgh, a.m0, 0);
+    shaniQuad(b.abef, b.cdgh, b.m0, 0);
+    shaniQuad(a.abef, a.cdgh, a.m1, 4);
+    shaniQuad(b.abef, b.cdgh, b.m1, 4);
+    shaniQuad(a.abef, a.cdgh, a.m2, 8);
+    shaniQuad(b.abef, b.cdgh, b.m2, 8);
+    shaniQuad(a.abef, a.cdgh, a.m3, 12);
+    shaniQuad(b.abef, b.cdgh, b.m3, 12);
+    for (size_t r = 16; r < 64; r += 16) {
+        a.m0 = shaniSchedule(a.m0, a.m1, a.m2, a.m3);
+        b.m0 = shaniSchedule(b.m0, b.m1, b.m2, b.m3);
+        shaniQuad(a.abef, a.cdgh, a.m0, r);
+        shaniQuad(b.abef, b.cdgh, b.m0, r);
+        a.m1 = shaniSchedule(a.m1, a.m2, a.m3, a.m0);
+        b.m1 = shaniSchedule(b.m1, b.m2, b.m3, b.m0);
+        shaniQuad(a.abef, a.cdgh, a.m1, r + 4);
+        shaniQuad(b.abef, b.cdgh, b.m1, r + 4);
+        a.m2 = shaniSchedule(a.m2, a.m3, a.m0, a.m1);
+        b.m2 = shaniSchedule(b.m2, b.m3, b.m0, b.m1);
+        shaniQuad(a.abef, a.cdgh, a.m2, r + 8);
+        shaniQuad(b.abef, b.cdgh, b.m2, r + 8);
+        a.m3 = shaniSchedule(a.m3, a.m0, a.m1, a.m2);
+        b.m3 = shaniSchedule(b.m3, b.m0, b.m1, b.m2);
+        shaniQuad(a.abef, a.cdgh, a.m3, r + 12);
+        shaniQuad(b.abef, b.cdgh, b.m3, r + 12);
+    }
+
+    shaniStore(a, abefA, cdghA, states[0]);
+    shaniStore(b, abefB, cdghB, states[1]);
+}
+
+#elif defined(__aarch64__)
+
+#if defined(__clang__)
+#define STFU_TARGET_SHA2 __attribute__((target("sha2")))
+#else
+#define STFU_TARGET_SHA2 __attribute__((target("+sha2")))
+#endif
+
+STFU_TARGET_SHA2
+static inline void armQuad(uint32x4_t& abcd, uint32x4_t& efgh, uint32x4_t msg, size_t round) {
+    uint32x4_t wk = vaddq_u32(msg, vld1q_u32(K + round));
+    uint32x4_t abcdIn = abcd;
+    abcd = vsha256hq_u32(abcd, efgh, wk);
+    efgh = vsha256h2q_u32(efgh, abcdIn, wk);
+}
+
+STFU_TARGET_SHA2
+static inline uint32x4_t armSchedule(uint32x4_t w0, uint32x4_t w1, uint32x4_t w2, uint32x4_t w3) {
+    return vsha256su1q_u32(vsha256su0q_u32(w0, w1), w2, w3);
+}
+
+struct ArmStream {
+    uint32x4_t abcd, efgh;
+    uint32x4_t m0, m1, m2, m3;
+};
+
+STFU_TARGET_SHA2
+static inline void armLoad(ArmStream& s, const uint32_t state[8], const uint8_t* block) {
+    s.abcd = vld1q_u32(state);
+    s.efgh = vld1q_u32(state + 4);
+    s.m0 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(block + 0)));
+    s.m1 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(block + 16)));
+    s.m2 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(block + 32)));
+    s.m3 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(block + 48)));
+}
+
+STFU_TARGET_SHA2
+static inline void armStore(const ArmStream& s, uint32x4_t abcd0, uint32x4_t efgh0, uint32_t state[8]) {
+    vst1q_u32(state, vaddq_u32(s.abcd, abcd0));
+    vst1q_u32(state + 4, vaddq_u32(s.efgh, efgh0));
+}
+
+STFU_TARGET_SHA2
+static void armCompressOne(uint32_t state[8], const uint8_t* block) {
+    ArmStream a;
+    armLoad(a, state, block);
+    const uint32x4_t abcd = a.abcd, efgh = a.efgh;
+
+    armQuad(a.abcd, a.efgh, a.m0, 0);
+    armQuad(a.abcd, a.efgh, a.m1, 4);
+    armQuad(a.abcd, a.efgh, a.m2, 8);
+    armQuad(a.abcd, a.efgh, a.m3, 12);
+    for (size_t r = 16; r < 64; r += 16) {
+        a.m0 = armSchedule(a.m0, a.m1, a.m2, a.m3);
+        armQuad(a.abcd, a.efgh, a.m0, r);
+        a.m1 = armSchedule(a.m1, a.m2, a.m3, a.m0);
+        armQuad(a.abcd, a.efgh, a.m1, r + 4);
+        a.m2 = armSchedule(a.m2, a.m3, a.m0, a.m1);
+        armQuad(a.abcd, a.efgh, a.m2, r + 8);
+        a.m3 = armSchedule(a.m3, a.m0, a.m1, a.m2);
+        armQuad(a.abcd, a.efgh, a.m3, r + 12);
+    }
+    armStore(a, abcd, efgh, state);
+}
+
+STFU_TARGET_SHA2
+static void armCompress(uint32_t (*states)[8], const uint8_t* const* blocks, size_t lanes) {
+    if (lanes == 1) {
+        armCompressOne(states[0], blocks[0]);
+        return;
+    }
+
+    ArmStream a, b;
+    armLoad(a, states[0], blocks[0]);
+    armLoad(b, states[1], blocks[1]);
+    const uint32x4_t abcdA = a.abcd, efghA = a.efgh;
+    const uint32x4_t abcdB = b.abcd, efghB = b.efgh;
+
+    armQuad(a.abcd, a.efgh, a.m0, 0);
+    armQuad(b.abcd, b.efgh, b.m0, 0);
+    armQuad(a.abcd, a.efgh, a.m1, 4);
+    armQuad(b.abcd, b.efgh, b.m1, 4);
+    armQuad(a.abcd, a.efgh, a.m2, 8);
+    armQuad(b.abcd, b.efgh, b.m2, 8);
+    armQuad(a.abcd, a.efgh, a.m3, 12);
+    armQuad(b.abcd, b.efgh, b.m3, 12);
+    for (size_t r = 16; r < 64; r += 16) {
+        a.m0 = armSchedule(a.m0, a.m1, a.m2, a.m3);
+        b.m0 = armSchedule(b.m0, b.m1, b.m2, b.m3);
+        armQuad(a.abcd, a.efgh, a.m0, r);
+        armQuad(b.abcd, b.efgh, b.m0, r);
+        a.m1 = armSchedule(a.m1, a.m2, a.m3, a.m0);
+        b.m1 = armSchedule(b.m1, b.m2, b.m3, b.m0);
+        armQuad(a.abcd, a.efgh, a.m1, r + 4);
+        armQuad(b.abcd, b.efgh, b.m1, r + 4);
+        a.m2 = armSchedule(a.m2, a.m3, a.m0, a.m1);
+        b.m2 = armSchedule(b.m2, b.m3, b.m0, b.m1);
+        armQuad(a.abcd, a.efgh, a.m2, r + 8);
+        armQuad(b.abcd, b.efgh, b.m2, r + 8);
+        a.m3 = armSchedule(a.m3, a.m0, a.m1, a.m2);
+        b.m3 = armSchedule(b.m3, b.m0, b.m1, b.m2);
+        armQuad(a.abcd, a.efgh, a.m3, r + 12);
+        armQuad(b.abcd, b.efgh, b.m3, r + 12);
+    }
+
+    armStore(a, abcdA, efghA, states[0]);
+    armStore(b, abcdB, efghB, states[1]);
+}
+
+#endif
+
+// Four 32-bit lanes, one message per lane; lowers to NEON on arm64 and SSE2 on x86
+typedef uint32_t ShaLanes __attribute__((vector_size(16)));
+
+static inline ShaLanes rotr(ShaLanes x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+static void portableCompress(uint32_t (*states)[8], const uint8_t* const* blocks, size_t lanes) {
+    ShaLanes w[16];
+    for (size_t t = 0; t < 16; t++) {
+        for (size_t l = 0; l < kMaxLanes; l++) {
+            w[t][l] = loadBigEndian(blocks[l < lanes ? l : 0] + 4 * t);
+        }
+    }
+
+    ShaLanes in[8];
+    for (size_t i = 0; i < 8; i++) {
+        for (size_t l = 0; l < kMaxLanes; l++) {
+            in[i][l] = states[l < lanes ? l : 0][i];
+        }
+    }
+
+    // Named working variables stay in vector registers through the rounds
+    ShaLanes a = in[0], b = in[1], c = in[2], d = in[3];
+    ShaLanes e = in[4], f = in[5], g = in[6], h = in[7];
+    for (size_t t = 0; t < 64; t++) {
+        if (t >= 16) {
+            ShaLanes w15 = w[(t - 15) & 15];
+            ShaLanes w2 = w[(t - 2) & 15];
+            ShaLanes s0 = rotr(w15, 7) ^ rotr(w15, 18) ^ (w15 >> 3);
+            ShaLanes s1 = rotr(w2, 17) ^ rotr(w2, 19) ^ (w2 >> 10);
+            w[t & 15] += s0 + w[(t - 7) & 15] + s1;
+        }
+        ShaLanes t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) +
+                      K[t] + w[t & 15];
+        ShaLanes t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    const ShaLanes out[8] = {a + in[0], b + in[1], c + in[2], d + in[3],
+                             e + in[4], f + in[5], g + in[6], h + in[7]};
+    for (size_t l = 0; l < lanes; l++) {
+        for (size_t i = 0; i < 8; i++) {
+            states[l][i] = out[i][l];
+        }
+    }
+}
+
+struct Backend {
+    CompressFn compress;
+    size_t lanes;
+    Sha256Kind kind;
+};
+
+static Backend selectBackend() {
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1")) {
+        return {shaniCompress, 2, SHA256_HARDWARE};
+    }
+#elif defined(__aarch64__)
+    if (getauxval(AT_HWCAP) & HWCAP_SHA2) {
+        return {armCompress, 2, SHA256_HARDWARE};
+    }
+#endif
+    return {portableCompress, kMaxLanes, SHA256_PORTABLE};
+}
+
+static const Backend g_backend = selectBackend();
+
+Sha256Kind sha256Kind() {
+    return g_backend.kind;
+}
+
+// A message as a run of blocks: whole blocks straight from the input, then
+// one or two padded tail blocks holding the remainder and the bit length
+struct PaddedMessage {
+    const uint8_t* data;
+    size_t wholeBlocks;
+    size_t blocks;
+    uint8_t tail[2 * kBlockSize];
+};
+
+static void padMessage(PaddedMessage& message, const uint8_t* data, size_t size,
+                       uint64_t prefixBytes) {
+    size_t rest = size % kBlockSize;
+    size_t tailBlocks = rest < kBlockSize - 8 ? 1 : 2;
+
+    message.data = data;
+    message.wholeBlocks = size / kBlockSize;
+    message.blocks = message.wholeBlocks + tailBlocks;
+    memset(message.tail, 0, tailBlocks * kBlockSize);
+    if (rest) memcpy(message.tail, data + message.wholeBlocks * kBlockSize, rest);
+    message.tail[rest] = 0x80;
+
+    uint64_t bits = (prefixBytes + size) * 8;
+    uint8_t* length = message.tail + tailBlocks * kBlockSize - 8;
+    for (int i = 0; i < 8; i++) {
+        length[i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+    }
+}
+
+static inline const uint8_t* blockAt(const PaddedMessage& message, size_t i) {
+    return i < message.wholeBlocks ? message.data + i * kBlockSize
+                                   : message.tail + (i - message.wholeBlocks) * kBlockSize;
+}
+
+static void storeDigest(const uint32_t state[8], uint8_t* digest) {
+    for (size_t i = 0; i < 8; i++) {
+        digest[4 * i + 0] = static_cast<uint8_t>(state[i] >> 24);
+        digest[4 * i + 1] = static_cast<uint8_t>(state[i] >> 16);
+        digest[4 * i + 2] = static_cast<uint8_t>(state[i] >> 8);
+        digest[4 * i + 3] = static_cast<uint8_t>(state[i]);
+    }
+}
+
+// Hash every input starting from `initial`, which has already absorbed
+// prefixBytes of a common prefix (a whole number of blocks)
+static void hashBatch(const uint32_t initial[8], uint64_t prefixBytes,
+                      const uint8_t* const* inputs, const size_t* sizes, size_t count,
+                      uint8_t* digests) {
+    const size_t width = g_backend.lanes;
+    PaddedMessage messages[kMaxLanes];
+    uint32_t states[kMaxLanes][8];
+
+    for (size_t first = 0; first < count; first += width) {
+        size_t lanes = std::min(width, count - first);
+        size_t rounds = 0;
+        for (size_t l = 0; l < lanes; l++) {
+            padMessage(messages[l], inputs[first + l], sizes[first + l], prefixBytes);
+            memcpy(states[l], initial, sizeof(states[l]));
+            rounds = std::max(rounds, messages[l].blocks);
+        }
+
+        // Lanes that run out early re-hash their own last block into a
+        // state whose digest is already stored
+        const uint8_t* blocks[kMaxLanes];
+        for (size_t i = 0; i < rounds; i++) {
+            for (size_t l = 0; l < lanes; l++) {
+                blocks[l] = blockAt(messages[l], std::min(i, messages[l].blocks - 1));
+            }
+            g_backend.compress(states, blocks, lanes);
+            for (size_t l = 0; l < lanes; l++) {
+                if (messages[l].blocks == i + 1) {
+                    storeDigest(states[l], digests + (first + l) * kSha256DigestSize);
+                }
+            }
+        }
+    }
+}
+
+void sha256Batch(const uint8_t* const* inputs, const size_t* sizes, size_t count,
+                 uint8_t* digests) {
+    hashBatch(INITIAL_STATE, 0, inputs, sizes, count, digests);
+}
+
+void sha256(const void* data, size_t size, uint8_t digest[kSha256DigestSize]) {
+    const uint8_t* input = static_cast<const uint8_t*>(data);
+    sha256Batch(&input, &size, 1, digest);
+}
+
+// State after absorbing one key block XORed with `pad`
+static void absorbKeyBlock(const uint8_t* key, size_t keySize, uint8_t pad, uint32_t state[8]) {
+    uint8_t block[kBlockSize];
+    memset(block, pad, sizeof(block));
+    for (size_t i = 0; i < keySize; i++) {
+        block[i] ^= key[i];
+    }
+
+    uint32_t states[1][8];
+    memcpy(states[0], INITIAL_STATE, sizeof(INITIAL_STATE));
+    const uint8_t* blocks[1] = {block};
+    g_backend.compress(states, blocks, 1);
+    memcpy(state, states[0], sizeof(states[0]));
+}
+
+void hmacSha256Batch(const uint8_t* key, size_t keySize, const uint8_t* const* inputs,
+                     const size_t* sizes, size_t count, uint8_t* macs) {
+    uint8_t hashedKey[kSha256DigestSize];
+    if (keySize > kBlockSize) {
+        sha256(key, keySize, hashedKey);
+        key = hashedKey;
+        keySize = sizeof(hashedKey);
+    }
+
+    // The padded key blocks are shared, so they are absorbed once per batch
+    uint32_t inner[8], outer[8];
+    absorbKeyBlock(key, keySize, 0x36, inner);
+    absorbKeyBlock(key, keySize, 0x5c, outer);
+
+    // Inner digests go straight into `macs`, then get hashed in place
+    hashBatch(inner, kBlockSize, inputs, sizes, count, macs);
+
+    constexpr size_t kOuterBatch = 64;
+    const uint8_t* innerDigests[kOuterBatch];
+    size_t digestSizes[kOuterBatch];
+    uint8_t outerDigests[kOuterBatch * kSha256DigestSize];
+    for (size_t first = 0; first < count; first += kOuterBatch) {
+        size_t n = std::min(kOuterBatch, count - first);
+        for (size_t i = 0; i < n; i++) {
+            innerDigests[i] = macs + (first + i) * kSha256DigestSize;
+            digestSizes[i] = kSha256DigestSize;
+        }
+        hashBatch(outer, kBlockSize, innerDigests, digestSizes, n, outerDigests);
+        memcpy(macs + first * kSha256DigestSize, outerDigests, n * kSha256DigestSize);
+    }
+}
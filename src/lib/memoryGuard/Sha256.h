@@ -0,0 +1,40 @@
+#ifndef STFU_SHA256_H
+#define STFU_SHA256_H
+
+#include <cstddef>
+#include <cstdint>
+
+// SHA-256 for many small inputs at once (game values, sync payloads).
+//
+// SHA-256 rounds form one long dependency chain, so a single message
+// leaves most of the core idle whatever instructions it uses. Batches are
+// hashed several messages at a time:
+//  - with ARMv8 SHA2 or x86 SHA-NI, two messages per call, their rounds
+//    interleaved so each fills the other's latency gaps;
+//  - otherwise four messages per call, one per 32-bit vector lane (NEON
+//    on arm64, SSE2 on x86).
+// Messages of different lengths share a call until the shorter one runs
+// out of blocks; its lane then carries filler that is never read back.
+//
+// The backend is chosen once at runtime and produces identical digests.
+
+constexpr size_t kSha256DigestSize = 32;
+
+enum Sha256Kind {
+    SHA256_PORTABLE = 0, // Four-lane SIMD
+    SHA256_HARDWARE = 1, // ARMv8 SHA2 / SHA-NI
+};
+
+Sha256Kind sha256Kind();
+
+void sha256(const void* data, size_t size, uint8_t digest[kSha256DigestSize]);
+
+// Hash `count` independent inputs; digests are written back to back
+void sha256Batch(const uint8_t* const* inputs, const size_t* sizes, size_t count,
+                 uint8_t* digests);
+
+// HMAC-SHA256 (RFC 2104) of every input under one key
+void hmacSha256Batch(const uint8_t* key, size_t keySize, const uint8_t* const* inputs,
+                     const size_t* sizes, size_t count, uint8_t* macs);
+
+#endif // STFU_SHA256_H
@@ -0,0 +1,95 @@
+#ifndef STFU_SHIELD_CONTEXT_H
+#define STFU_SHIELD_CONTEXT_H
+
+#include <jni.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "DecoyEngine.h"
+#include "LivenessMonitor.h"
+#include "PackageWatch.h"
+#include "PerfCounters.h"
+#include "ProcReader.h"
+#include "RegionGuard.h"
+#include "SealedTable.h"
+#include "SnapshotVerifier.h"
+#include "StallWatchdog.h"
+#include "ValueJournal.h"
+#include "ValueStore.h"
+#include "Vault.h"
+
+// Everything one GameGuardianShield instance owns on the native side.
+//
+// A context is created with the Java object and a handle to it is kept in
+// the object's nativeContext field, so every instance (the game, an SDK
+// embedded in it, parallel test cases) has its own registry, session key,
+// sealed table, value store, watchdog and lock. Contexts share no other
+// mutable state and take no common lock; only the JavaVM pointer, read-only
+// tables, each thread's cached journal ring and the handle table (see
+// HandleTable.h) are process-wide. JNI calls hold the context through its
+// handle, so nativeDestroy can wait for the calls still running.
+
+struct ShieldContext;
+
+// A protected region and the context whose sealed table holds its
+// baseline. Region handles resolve to these, so the native write API can
+// find the right table from the handle alone.
+struct ShieldRegion {
+    MemoryRegion region;
+    ShieldContext* context;
+};
+
+struct ShieldContext {
+    std::mutex mutex; // Guards everything below that is not atomic or thread-owned
+    bool initialized = false;
+    std::mt19937 rng;
+
+    // Protected memory
+    std::vector<std::unique_ptr<ShieldRegion>> regions;
+    std::vector<std::unique_ptr<Vault>> vaults;
+    SealedTable sealedTable{};
+    int checksSinceRelocation = 0;
+    int integrityMode = INTEGRITY_KEYED_TREE;
+    SnapshotVerifier snapshot{};
+    bool snapshotMode = false;
+    std::atomic<bool> cpuPlacement{true}; // Detectors run under ScopedCpuPlacement
+    std::atomic<bool> perfCounters{false};
+    DetectorStats detectorStats[kDetectors];
+    std::vector<MemoryRegion*> attestRegions; // Static regions, in registration order
+
+    // Protected values
+    ValueStore valueStore{};
+    DecoyEngine decoys{};
+    std::atomic<int64_t> relocationBudgetNs;
+    std::atomic<uint64_t> reportedRedundancyFaults{0};
+    ValueJournal journal{};
+
+    // /proc detectors
+    std::mutex procMutex; // Guards procReader and the data it returns
+    ProcReader procReader{};
+    bool procReaderReady = false;
+    PackageWatch packageWatch{};
+    std::atomic<bool> cheatPackageInstalled{false}; // Cached result of the last package comparison
+    std::vector<std::string> rootPaths;            // Root probe table; empty means kDefaultRootPaths
+    std::atomic<int> rootSignals{-1};              // Memoized RootSignal bits, -1 until computed
+
+    // Watchdog and liveness
+    StallWatchdog stallWatchdog{};
+    uint64_t reportedStalls = 0;
+    LivenessMonitor liveness{};
+    LivenessChecker watchdogChecker{};  // Used only on the watchdog thread
+    LivenessChecker integrityChecker{}; // Used only on the Java check thread
+    int watchdogSlot = -1;
+    jobject shieldRef = nullptr;        // Global ref for watchdog callbacks
+
+    explicit ShieldContext(int64_t defaultRelocationBudgetNs)
+        : relocationBudgetNs(defaultRelocationBudgetNs) {}
+};
+
+#endif // STFU_SHIELD_CONTEXT_H
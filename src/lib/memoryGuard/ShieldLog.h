@@ -0,0 +1,11 @@
+#ifndef STFU_SHIELD_LOG_H
+#define STFU_SHIELD_LOG_H
+
+#include <android/log.h>
+
+#define TAG "STFUGameGuardian"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+#endif // STFU_SHIELD_LOG_H
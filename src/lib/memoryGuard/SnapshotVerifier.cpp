@@ -0,0 +1,102 @@
+#include "SnapshotVerifier.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ShieldLog.h"
+
+static int64_t monotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// Child side: async-signal-safe calls only, then _exit without running
+// any of the parent's atexit handlers or destructors
+static void runChild(int fd, const SealedTable& table, const std::vector<MemoryRegion*>& regions) {
+    for (size_t i = 0; i < regions.size(); i++) {
+        if (!verifyRegionSnapshot(table, *regions[i])) {
+            uint32_t index = static_cast<uint32_t>(i);
+            ssize_t ignored = write(fd, &index, sizeof(index));
+            (void) ignored;
+            break;
+        }
+    }
+    _exit(0);
+}
+
+bool snapshotStart(SnapshotVerifier& verifier, const SealedTable& table,
+                   const std::vector<MemoryRegion*>& regions) {
+    if (verifier.child > 0) return false;
+
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        LOGW("Snapshot pipe failed: %d", errno);
+        return false;
+    }
+
+    verifier.regions = regions;
+
+    int64_t start = monotonicNs();
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        runChild(fds[1], table, verifier.regions);
+    }
+    int64_t forkNs = monotonicNs() - start;
+
+    close(fds[1]);
+    if (pid < 0) {
+        LOGW("Snapshot fork failed: %d", errno);
+        close(fds[0]);
+        return false;
+    }
+
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    verifier.child = pid;
+    verifier.pipeFd = fds[0];
+    verifier.lastForkNs = forkNs;
+    if (forkNs > verifier.maxForkNs) verifier.maxForkNs = forkNs;
+    verifier.forks++;
+    return true;
+}
+
+static void closeChild(SnapshotVerifier& verifier) {
+    close(verifier.pipeFd);
+    verifier.pipeFd = -1;
+    verifier.child = -1;
+}
+
+SnapshotResult snapshotPoll(SnapshotVerifier& verifier, MemoryRegion** tampered) {
+    if (verifier.child <= 0) return SNAPSHOT_IDLE;
+
+    int status = 0;
+    pid_t reaped = waitpid(verifier.child, &status, WNOHANG);
+    if (reaped == 0) return SNAPSHOT_PENDING;
+
+    // The verdict was written before exit, so it is already in the pipe
+    uint32_t index = 0;
+    ssize_t got = read(verifier.pipeFd, &index, sizeof(index));
+    closeChild(verifier);
+
+    if (reaped < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return SNAPSHOT_FAILED;
+    }
+    if (got == static_cast<ssize_t>(sizeof(index)) && index < verifier.regions.size()) {
+        *tampered = verifier.regions[index];
+        return SNAPSHOT_TAMPERED;
+    }
+    return SNAPSHOT_INTACT;
+}
+
+void snapshotCancel(SnapshotVerifier& verifier) {
+    if (verifier.child <= 0) return;
+
+    kill(verifier.child, SIGKILL);
+    waitpid(verifier.child, nullptr, 0);
+    closeChild(verifier);
+}
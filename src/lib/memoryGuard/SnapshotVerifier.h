@@ -0,0 +1,54 @@
+#ifndef STFU_SNAPSHOT_VERIFIER_H
+#define STFU_SNAPSHOT_VERIFIER_H
+
+#include <cstdint>
+#include <sys/types.h>
+#include <vector>
+
+#include "RegionGuard.h"
+#include "SealedTable.h"
+
+// Full region scans against a copy-on-write snapshot of the process.
+//
+// fork() freezes every protected region, its sequence counters and the
+// sealed baselines at one instant. A short-lived child hashes that frozen
+// copy on whatever core the scheduler gives it and writes the index of the
+// first tampered region (nothing if all are intact) to a pipe before
+// exiting. The parent pays only for the fork and collects the verdict on a
+// later check without blocking, so game writers never wait on a scan and
+// the scan never sees a torn write.
+//
+// While a child runs, pages the game writes are copied once by the kernel;
+// that cost lands on the writer, not on the check.
+
+enum SnapshotResult {
+    SNAPSHOT_IDLE = 0,     // No child running
+    SNAPSHOT_PENDING = 1,  // Child still hashing
+    SNAPSHOT_INTACT = 2,
+    SNAPSHOT_TAMPERED = 3,
+    SNAPSHOT_FAILED = 4,   // Child crashed or was killed; inconclusive
+};
+
+struct SnapshotVerifier {
+    pid_t child = -1;
+    int pipeFd = -1;
+    std::vector<MemoryRegion*> regions; // As ordered at fork time
+    int64_t lastForkNs = 0;
+    int64_t maxForkNs = 0;
+    uint64_t forks = 0;
+};
+
+// Fork a child to check `regions` as they are right now. False if a child
+// is already running or the fork failed. Callers keep the regions alive
+// until the result is collected or the snapshot is cancelled.
+bool snapshotStart(SnapshotVerifier& verifier, const SealedTable& table,
+                   const std::vector<MemoryRegion*>& regions);
+
+// Collect the running child's verdict without blocking. On SNAPSHOT_TAMPERED
+// *tampered is the first region that failed.
+SnapshotResult snapshotPoll(SnapshotVerifier& verifier, MemoryRegion** tampered);
+
+// Kill and reap a running child
+void snapshotCancel(SnapshotVerifier& verifier);
+
+#endif // STFU_SNAPSHOT_VERIFIER_H
@@ -0,0 +1,127 @@
+#include "StallWatchdog.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ShieldLog.h"
+
+static int64_t clockNs(clockid_t clock) {
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+static size_t bucketFor(int64_t latenessNs) {
+    int64_t ms = latenessNs / 1000000;
+    if (ms <= 0) return 0;
+    size_t bucket = 1 + (63 - __builtin_clzll(static_cast<uint64_t>(ms)));
+    return bucket < kStallBuckets ? bucket : kStallBuckets - 1;
+}
+
+static void recordWake(StallWatchdog& watchdog, int64_t monoGap, int64_t bootGap) {
+    // A suspend shorter than a period cannot be told apart from clock noise
+    int64_t suspendedNs = bootGap - monoGap;
+    bool resumed = suspendedNs > watchdog.periodNs;
+
+    int64_t lateness = monoGap - watchdog.periodNs;
+    if (lateness < 0) lateness = 0;
+
+    watchdog.wakes.fetch_add(1, std::memory_order_relaxed);
+    watchdog.histogram[bucketFor(lateness)].fetch_add(1, std::memory_order_relaxed);
+
+    if (resumed) {
+        watchdog.suspends.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (lateness < watchdog.stallThresholdNs) return;
+
+    watchdog.stalls.fetch_add(1, std::memory_order_relaxed);
+    if (lateness > watchdog.longestStallNs.load(std::memory_order_relaxed)) {
+        watchdog.longestStallNs.store(lateness, std::memory_order_relaxed);
+    }
+    LOGW("Process stalled for %lld ms", static_cast<long long>(lateness / 1000000));
+}
+
+static void runWatchdog(StallWatchdog* watchdog) {
+    pthread_setname_np(pthread_self(), "stfu-stallwatch");
+
+    pollfd fds[2] = {
+        {watchdog->timerFd, POLLIN, 0},
+        {watchdog->stopFd, POLLIN, 0},
+    };
+    int64_t lastMono = clockNs(CLOCK_MONOTONIC);
+    int64_t lastBoot = clockNs(CLOCK_BOOTTIME);
+
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            LOGW("Stall watchdog poll failed: %d", errno);
+            return;
+        }
+        if (fds[1].revents) return;
+
+        // The expiration count is implied by the clock gap; just drain it
+        uint64_t expirations;
+        if (read(watchdog->timerFd, &expirations, sizeof(expirations)) < 0) continue;
+
+        int64_t mono = clockNs(CLOCK_MONOTONIC);
+        int64_t boot = clockNs(CLOCK_BOOTTIME);
+        recordWake(*watchdog, mono - lastMono, boot - lastBoot);
+        if (watchdog->onWake) watchdog->onWake(watchdog->onWakeArg, mono);
+        lastMono = mono;
+        lastBoot = boot;
+    }
+}
+
+static void closeFds(StallWatchdog& watchdog) {
+    if (watchdog.timerFd >= 0) close(watchdog.timerFd);
+    if (watchdog.stopFd >= 0) close(watchdog.stopFd);
+    watchdog.timerFd = -1;
+    watchdog.stopFd = -1;
+}
+
+bool stallWatchdogStart(StallWatchdog& watchdog, int64_t periodNs, int64_t stallThresholdNs) {
+    if (watchdog.thread.joinable() || periodNs <= 0) return false;
+
+    watchdog.timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    watchdog.stopFd = eventfd(0, EFD_CLOEXEC);
+    if (watchdog.timerFd < 0 || watchdog.stopFd < 0) {
+        LOGW("Stall watchdog setup failed: %d", errno);
+        closeFds(watchdog);
+        return false;
+    }
+
+    itimerspec spec = {};
+    spec.it_interval.tv_sec = periodNs / 1000000000LL;
+    spec.it_interval.tv_nsec = periodNs % 1000000000LL;
+    spec.it_value = spec.it_interval;
+    if (timerfd_settime(watchdog.timerFd, 0, &spec, nullptr) != 0) {
+        LOGW("Stall watchdog timer failed: %d", errno);
+        closeFds(watchdog);
+        return false;
+    }
+
+    watchdog.periodNs = periodNs;
+    watchdog.stallThresholdNs = stallThresholdNs;
+    watchdog.thread = std::thread(runWatchdog, &watchdog);
+    return true;
+}
+
+void stallWatchdogStop(StallWatchdog& watchdog) {
+    if (!watchdog.thread.joinable()) return;
+
+    uint64_t one = 1;
+    ssize_t ignored = write(watchdog.stopFd, &one, sizeof(one));
+    (void) ignored;
+    watchdog.thread.join();
+    closeFds(watchdog);
+}
+
+bool stallWatchdogRunning(const StallWatchdog& watchdog) {
+    return watchdog.thread.joinable();
+}
@@ -0,0 +1,63 @@
+#ifndef STFU_STALL_WATCHDOG_H
+#define STFU_STALL_WATCHDOG_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+// Heartbeat watchdog that notices the whole process being frozen.
+//
+// Memory editors often SIGSTOP or ptrace-stop the game while they scan it.
+// A frozen process runs none of its checks, so the periodic Java loop can
+// never see the freeze. This thread sleeps on a periodic CLOCK_MONOTONIC
+// timerfd and, on every wake, measures the gap since the previous wake on
+// both CLOCK_MONOTONIC and CLOCK_BOOTTIME.
+//
+// How gaps are read:
+//  - BOOTTIME keeps counting while the device is suspended and MONOTONIC
+//    does not, so a BOOTTIME-only gap is doze or sleep. The wake right
+//    after a resume is never flagged, because resume storms can delay it.
+//  - A MONOTONIC gap well past the period, with no suspend in it, means
+//    this process stopped running while the device did not.
+//  - Anything under the stall threshold is ordinary scheduler jitter. It
+//    only goes into the histogram.
+//
+// Between wakes the thread is blocked in poll() and costs nothing. Each
+// wake is a few clock reads and relaxed atomic adds.
+//
+// Android's cached-app freezer also stops backgrounded processes, so the
+// host should stop the watchdog while the game is in the background.
+
+// Log2 buckets of wake lateness: [0,1) ms, [1,2) ms, [2,4) ms ... >= 8 s
+constexpr size_t kStallBuckets = 15;
+
+struct StallWatchdog {
+    std::thread thread;
+    int timerFd = -1;
+    int stopFd = -1; // eventfd that wakes the thread for shutdown
+    int64_t periodNs = 0;
+    int64_t stallThresholdNs = 0;
+
+    // Optional hook run on the watchdog thread after every wake, with
+    // onWakeArg and the CLOCK_MONOTONIC time of the wake. Set before starting.
+    void (*onWake)(void* arg, int64_t nowNs) = nullptr;
+    void* onWakeArg = nullptr;
+
+    std::atomic<uint64_t> histogram[kStallBuckets] = {};
+    std::atomic<uint64_t> wakes{0};
+    std::atomic<uint64_t> stalls{0};   // Process freezes
+    std::atomic<uint64_t> suspends{0}; // Device suspends, not reported
+    std::atomic<int64_t> longestStallNs{0};
+};
+
+// Start the heartbeat thread. Wakes later than stallThresholdNs past the
+// period count as process freezes. False if already running or setup failed.
+bool stallWatchdogStart(StallWatchdog& watchdog, int64_t periodNs, int64_t stallThresholdNs);
+
+// Stop and join the heartbeat thread; counters are kept
+void stallWatchdogStop(StallWatchdog& watchdog);
+
+bool stallWatchdogRunning(const StallWatchdog& watchdog);
+
+#endif // STFU_STALL_WATCHDOG_H
@@ -0,0 +1,182 @@
+#include "ValueJournal.h"
+
+#include <errno.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstring>
+
+// The calling thread's ring in the journal it last recorded to
+struct JournalThreadCache {
+    const ValueJournal* journal;
+    uint64_t id;
+    JournalRing* ring;
+};
+
+static thread_local JournalThreadCache t_journalCache = {nullptr, 0, nullptr};
+
+static std::atomic<uint64_t> g_nextJournalId{1};
+
+static inline uint64_t coarseNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+// Called with the journal mutex held
+static void assignId(ValueJournal& journal) {
+    if (journal.id.load(std::memory_order_relaxed) == 0) {
+        journal.id.store(g_nextJournalId.fetch_add(1, std::memory_order_relaxed),
+                         std::memory_order_relaxed);
+    }
+}
+
+static bool threadExited(pid_t tid) {
+    return syscall(SYS_tgkill, getpid(), tid, 0) == -1 && errno == ESRCH;
+}
+
+// Find the calling thread's ring, or claim one. Rings stay with their
+// thread; a ring whose thread has exited is reused once it is drained.
+static JournalRing* claimRing(ValueJournal& journal) {
+    std::lock_guard<std::mutex> lock(journal.mutex);
+    assignId(journal);
+    pid_t self = gettid();
+
+    JournalRing* unused = nullptr;
+    JournalRing* abandoned = nullptr;
+    for (JournalRing& ring : journal.rings) {
+        if (!ring.claimed.load(std::memory_order_relaxed)) {
+            if (!unused) unused = &ring;
+        } else if (ring.tid == self) {
+            return &ring;
+        } else if (!abandoned &&
+                   ring.head.load(std::memory_order_relaxed) == ring.tail.load(std::memory_order_acquire) &&
+                   threadExited(ring.tid)) {
+            abandoned = &ring;
+        }
+    }
+
+    JournalRing* ring = unused ? unused : abandoned;
+    if (!ring) return nullptr;
+    if (!ring->records) {
+        ring->records = new JournalRecord[kJournalRingRecords];
+    }
+    ring->tid = self;
+    ring->tag = 0;
+    ring->cachedHead = ring->head.load(std::memory_order_relaxed);
+    ring->claimed.store(true, std::memory_order_release);
+    return ring;
+}
+
+// Slow path of threadRing(), kept out of line so the cached case stays a
+// few loads in journalAppend()
+__attribute__((noinline)) static JournalRing* cacheThreadRing(ValueJournal& journal) {
+    JournalRing* ring = claimRing(journal);
+    if (ring) {
+        t_journalCache = {&journal, journal.id.load(std::memory_order_relaxed), ring};
+    }
+    return ring;
+}
+
+static inline JournalRing* threadRing(ValueJournal& journal) {
+    const JournalThreadCache& cache = t_journalCache;
+    if (cache.journal == &journal && cache.id == journal.id.load(std::memory_order_relaxed)) {
+        return cache.ring;
+    }
+    return cacheThreadRing(journal);
+}
+
+void journalSetEnabled(ValueJournal& journal, bool enabled) {
+    std::lock_guard<std::mutex> lock(journal.mutex);
+    if (enabled) assignId(journal);
+    journal.enabled.store(enabled, std::memory_order_release);
+}
+
+void journalDestroy(ValueJournal& journal) {
+    std::lock_guard<std::mutex> lock(journal.mutex);
+    journal.enabled.store(false);
+    for (JournalRing& ring : journal.rings) {
+        delete[] ring.records;
+        ring.records = nullptr;
+        ring.claimed.store(false);
+        ring.head.store(0);
+        ring.tail.store(0);
+    }
+}
+
+void journalAppend(ValueJournal& journal, int64_t handle, uint64_t before, uint64_t after,
+                   JournalValueType type, JournalOp op) {
+    JournalRing* ring = threadRing(journal);
+    if (!ring) {
+        journal.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    if (tail - ring->cachedHead >= kJournalRingRecords) {
+        ring->cachedHead = ring->head.load(std::memory_order_acquire);
+        if (tail - ring->cachedHead >= kJournalRingRecords) {
+            ring->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    JournalRecord& record = ring->records[tail % kJournalRingRecords];
+    record.timeNs = coarseNs();
+    record.before = before;
+    record.after = after;
+    record.handle = static_cast<uint32_t>(handle);
+    record.tag = ring->tag;
+    record.type = type;
+    record.op = op;
+    ring->tail.store(tail + 1, std::memory_order_release);
+}
+
+void journalSetTag(ValueJournal& journal, uint16_t tag) {
+    JournalRing* ring = threadRing(journal);
+    if (ring) ring->tag = tag;
+}
+
+size_t journalPending(ValueJournal& journal) {
+    size_t pending = 0;
+    for (JournalRing& ring : journal.rings) {
+        if (!ring.claimed.load(std::memory_order_acquire)) continue;
+        pending += ring.tail.load(std::memory_order_acquire) - ring.head.load(std::memory_order_relaxed);
+    }
+    return pending;
+}
+
+size_t journalDrain(ValueJournal& journal, uint8_t* out, size_t maxRecords) {
+    std::lock_guard<std::mutex> lock(journal.mutex);
+
+    uint8_t* cursor = out + sizeof(JournalHeader);
+    size_t count = 0;
+    uint32_t dropped = journal.dropped.exchange(0, std::memory_order_relaxed);
+
+    for (JournalRing& ring : journal.rings) {
+        if (!ring.claimed.load(std::memory_order_acquire)) continue;
+        dropped += ring.dropped.exchange(0, std::memory_order_relaxed);
+
+        uint64_t head = ring.head.load(std::memory_order_relaxed);
+        uint64_t tail = ring.tail.load(std::memory_order_acquire);
+        for (; head < tail && count < maxRecords; head++, count++) {
+            memcpy(cursor, &ring.records[head % kJournalRingRecords], sizeof(JournalRecord));
+            cursor += sizeof(JournalRecord);
+        }
+        ring.head.store(head, std::memory_order_release);
+    }
+
+    timespec resolution;
+    clock_getres(CLOCK_MONOTONIC_COARSE, &resolution);
+
+    JournalHeader header;
+    header.magic = kJournalMagic;
+    header.count = static_cast<uint32_t>(count);
+    header.nowNs = coarseNs();
+    header.dropped = dropped;
+    header.resolutionNs = static_cast<uint32_t>(resolution.tv_nsec);
+    header.reserved = 0;
+    memcpy(out, &header, sizeof(header));
+    return static_cast<size_t>(cursor - out);
+}
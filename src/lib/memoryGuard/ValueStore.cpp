@@ -0,0 +1,418 @@
+#include "ValueStore.h"
+
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+
+// Entry layout: slot index (high 32 bits) | version (bits 1-31) | write bit
+constexpr uint64_t kWriteBit = 1;
+constexpr uint64_t kVersionMask = 0xFFFFFFFEull;
+constexpr uint32_t kNoSlot = 0xFFFFFFFFu;
+constexpr uint64_t kNoReplicas = ~0ull;
+
+// XORed into a single value's masked word when it is moved away, so CASes
+// that still expect the old contents fail
+constexpr uint64_t kMovedMark = 0x9E3779B97F4A7C15ull;
+
+// Values relocated between budget checks
+constexpr size_t kRelocateClockStride = 16;
+
+// Random free-list probes before mapping a page to place a replica
+constexpr int kAllocateProbes = 8;
+
+static inline uint32_t entrySlot(uint64_t entry) {
+    return static_cast<uint32_t>(entry >> 32);
+}
+
+static inline uint64_t makeEntry(uint32_t slot, uint64_t previous) {
+    uint64_t version = ((previous & kVersionMask) + 2) & kVersionMask;
+    return (static_cast<uint64_t>(slot) << 32) | version;
+}
+
+static inline uint64_t majority(uint64_t a, uint64_t b, uint64_t c) {
+    return (a & b) | (a & c) | (b & c);
+}
+
+static int64_t monotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// xorshift64*; only used with the store mutex held
+static uint64_t nextRandom(ValueStore& store) {
+    uint64_t x = store.rngState;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    store.rngState = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static ValueSlot* slotAt(const ValueStore& store, uint32_t index) {
+    ValueSlot* chunk = store.slotChunks[index / kSlotsPerChunk].load(std::memory_order_acquire);
+    return &chunk[index % kSlotsPerChunk];
+}
+
+static std::atomic<uint64_t>* entryAt(const ValueStore& store, int64_t handle) {
+    if (handle <= 0) return nullptr;
+
+    uint64_t index = static_cast<uint64_t>(handle - 1);
+    if (index >= store.entryCount.load(std::memory_order_acquire)) return nullptr;
+
+    std::atomic<uint64_t>* chunk =
+            store.entryChunks[index / kEntriesPerChunk].load(std::memory_order_acquire);
+    return &chunk[index % kEntriesPerChunk];
+}
+
+static uint64_t lockEntry(std::atomic<uint64_t>* entry) {
+    for (;;) {
+        uint64_t current = entry->load(std::memory_order_relaxed);
+        if (current & kWriteBit) {
+            sched_yield();
+        } else if (entry->compare_exchange_weak(current, current | kWriteBit,
+                                                std::memory_order_acquire,
+                                                std::memory_order_relaxed)) {
+            return current;
+        }
+    }
+}
+
+// Slots holding a value: the primary plus its replicas, if any
+static int slotGroup(const ValueStore& store, uint32_t primary, uint32_t group[kRedundantCopies]) {
+    group[0] = primary;
+    uint64_t replicas = slotAt(store, primary)->replicas.load(std::memory_order_relaxed);
+    if (replicas == kNoReplicas) return 1;
+
+    group[1] = static_cast<uint32_t>(replicas >> 32);
+    group[2] = static_cast<uint32_t>(replicas);
+    return kRedundantCopies;
+}
+
+static inline uint64_t readCopy(const ValueStore& store, uint32_t index) {
+    ValueSlot* slot = slotAt(store, index);
+    return slot->masked.load(std::memory_order_relaxed) ^ slot->key.load(std::memory_order_relaxed);
+}
+
+static inline void writeCopy(const ValueStore& store, uint32_t index, uint64_t bits) {
+    ValueSlot* slot = slotAt(store, index);
+    slot->masked.store(bits ^ slot->key.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+// Take a single value out of its slot for relocation. Called with the entry
+// locked; the release orders the lock before the mark for lock-free readers.
+static inline uint64_t retireCopy(const ValueStore& store, uint32_t index) {
+    ValueSlot* slot = slotAt(store, index);
+    return slot->masked.fetch_xor(kMovedMark, std::memory_order_acq_rel) ^
+           slot->key.load(std::memory_order_relaxed);
+}
+
+// Map one more page of slots. Called with the store mutex held.
+static bool mapChunk(ValueStore& store) {
+    if (store.slotChunkCount >= kMaxSlotChunks) return false;
+
+    void* page = mmap(nullptr, sizeof(ValueSlot) * kSlotsPerChunk, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (page == MAP_FAILED) return false;
+
+    size_t chunk = store.slotChunkCount++;
+    store.slotChunks[chunk].store(static_cast<ValueSlot*>(page), std::memory_order_release);
+    for (size_t i = 0; i < kSlotsPerChunk; i++) {
+        store.freeSlots.push_back(static_cast<uint32_t>(chunk * kSlotsPerChunk + i));
+    }
+    return true;
+}
+
+static uint32_t takeFree(ValueStore& store, size_t pick) {
+    uint32_t slot = store.freeSlots[pick];
+    store.freeSlots[pick] = store.freeSlots.back();
+    store.freeSlots.pop_back();
+    store.slotsInUse++;
+    return slot;
+}
+
+static void releaseSlot(ValueStore& store, uint32_t slot) {
+    store.freeSlots.push_back(slot);
+    store.slotsInUse--;
+}
+
+static bool sharesPage(uint32_t slot, const uint32_t* taken, int count) {
+    for (int i = 0; i < count; i++) {
+        if (slot / kSlotsPerChunk == taken[i] / kSlotsPerChunk) return true;
+    }
+    return false;
+}
+
+// Pick a random free slot on a page none of `taken` is on, keeping at least
+// as many free slots as used ones. Called with the store mutex held.
+static uint32_t allocateSlot(ValueStore& store, const uint32_t* taken, int takenCount) {
+    if (store.freeSlots.size() <= store.slotsInUse) {
+        mapChunk(store);
+    }
+
+    for (int probe = 0; probe < kAllocateProbes && !store.freeSlots.empty(); probe++) {
+        size_t pick = nextRandom(store) % store.freeSlots.size();
+        if (!sharesPage(store.freeSlots[pick], taken, takenCount)) {
+            return takeFree(store, pick);
+        }
+    }
+
+    // A freshly mapped page never shares with the others
+    if (!mapChunk(store)) return kNoSlot;
+    size_t pick = store.freeSlots.size() - 1 - nextRandom(store) % kSlotsPerChunk;
+    return takeFree(store, pick);
+}
+
+static bool allocateGroup(ValueStore& store, int count, uint32_t group[kRedundantCopies]) {
+    for (int i = 0; i < count; i++) {
+        group[i] = allocateSlot(store, group, i);
+        if (group[i] == kNoSlot) {
+            while (i-- > 0) releaseSlot(store, group[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Give every copy a fresh key and link the replicas from the primary
+static void fillGroup(ValueStore& store, const uint32_t* group, int count, uint64_t bits) {
+    for (int i = 0; i < count; i++) {
+        ValueSlot* slot = slotAt(store, group[i]);
+        uint64_t key = nextRandom(store);
+        slot->key.store(key, std::memory_order_relaxed);
+        slot->masked.store(bits ^ key, std::memory_order_relaxed);
+        slot->replicas.store(kNoReplicas, std::memory_order_relaxed);
+    }
+    if (count == kRedundantCopies) {
+        uint64_t replicas = (static_cast<uint64_t>(group[1]) << 32) | group[2];
+        slotAt(store, group[0])->replicas.store(replicas, std::memory_order_relaxed);
+    }
+}
+
+// Vote over a locked entry's copies and rewrite any that disagree
+static uint64_t voteLocked(ValueStore& store, const uint32_t* group, int count) {
+    if (count == 1) return readCopy(store, group[0]);
+
+    uint64_t a = readCopy(store, group[0]);
+    uint64_t b = readCopy(store, group[1]);
+    uint64_t c = readCopy(store, group[2]);
+    uint64_t value = majority(a, b, c);
+
+    if (((a ^ b) | (a ^ c)) != 0) {
+        store.redundancyFaults.fetch_add(1, std::memory_order_relaxed);
+        for (int i = 0; i < count; i++) {
+            writeCopy(store, group[i], value);
+        }
+    }
+    return value;
+}
+
+static void repairEntry(ValueStore& store, std::atomic<uint64_t>* entry) {
+    uint64_t current = lockEntry(entry);
+    uint32_t group[kRedundantCopies];
+    int count = slotGroup(store, entrySlot(current), group);
+    voteLocked(store, group, count);
+    entry->store(makeEntry(entrySlot(current), current), std::memory_order_release);
+}
+
+void valueStoreInit(ValueStore& store, uint64_t seed) {
+    std::lock_guard<std::mutex> lock(store.mutex);
+    store.rngState = seed | 1;
+    store.relocateCursor = 0;
+    store.relocations = 0;
+    store.redundancyFaults.store(0);
+}
+
+void valueStoreDestroy(ValueStore& store) {
+    std::lock_guard<std::mutex> lock(store.mutex);
+
+    for (size_t i = 0; i < store.slotChunkCount; i++) {
+        munmap(store.slotChunks[i].load(), sizeof(ValueSlot) * kSlotsPerChunk);
+        store.slotChunks[i].store(nullptr);
+    }
+    for (auto& chunk : store.entryChunks) {
+        delete[] chunk.load();
+        chunk.store(nullptr);
+    }
+
+    store.entryCount.store(0);
+    store.freeSlots.clear();
+    store.slotChunkCount = 0;
+    store.slotsInUse = 0;
+    store.relocateCursor = 0;
+}
+
+int64_t valueStoreCreate(ValueStore& store, uint64_t bits, bool redundant) {
+    std::lock_guard<std::mutex> lock(store.mutex);
+
+    uint32_t index = store.entryCount.load(std::memory_order_relaxed);
+    if (index >= kEntriesPerChunk * kMaxEntryChunks) return 0;
+
+    auto& chunk = store.entryChunks[index / kEntriesPerChunk];
+    if (!chunk.load(std::memory_order_relaxed)) {
+        chunk.store(new std::atomic<uint64_t>[kEntriesPerChunk], std::memory_order_release);
+    }
+
+    int count = redundant ? kRedundantCopies : 1;
+    uint32_t group[kRedundantCopies];
+    if (!allocateGroup(store, count, group)) return 0;
+    fillGroup(store, group, count, bits);
+
+    chunk.load(std::memory_order_relaxed)[index % kEntriesPerChunk]
+            .store(makeEntry(group[0], 0), std::memory_order_relaxed);
+    store.entryCount.store(index + 1, std::memory_order_release);
+    return static_cast<int64_t>(index) + 1;
+}
+
+bool valueStoreGet(ValueStore& store, int64_t handle, uint64_t* bits) {
+    std::atomic<uint64_t>* entry = entryAt(store, handle);
+    if (!entry) return false;
+
+    for (;;) {
+        uint64_t before = entry->load(std::memory_order_acquire);
+        uint32_t group[kRedundantCopies];
+        int count = slotGroup(store, entrySlot(before), group);
+
+        if (count == 1) {
+            // A set write bit means the value is being moved out of this slot
+            if (before & kWriteBit) {
+                sched_yield();
+                continue;
+            }
+            uint64_t value = readCopy(store, group[0]);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (entry->load(std::memory_order_relaxed) == before) {
+                *bits = value;
+                return true;
+            }
+            continue;
+        }
+
+        // Redundant sets bump the version, so an unchanged, unlocked entry
+        // means no copy was being written while we read them
+        uint64_t a = readCopy(store, group[0]);
+        uint64_t b = readCopy(store, group[1]);
+        uint64_t c = readCopy(store, group[2]);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if ((before & kWriteBit) || entry->load(std::memory_order_relaxed) != before) {
+            sched_yield();
+            continue;
+        }
+
+        *bits = majority(a, b, c);
+        if (((a ^ b) | (a ^ c)) != 0) {
+            repairEntry(store, entry);
+        }
+        return true;
+    }
+}
+
+// Shared by set and update: `compute(current, &next)` returns false to
+// leave the value alone
+template <typename Compute>
+static bool updateEntry(ValueStore& store, int64_t handle, Compute compute,
+                        uint64_t* before, uint64_t* after) {
+    std::atomic<uint64_t>* entry = entryAt(store, handle);
+    if (!entry) return false;
+
+    for (;;) {
+        uint64_t observed = entry->load(std::memory_order_acquire);
+        uint32_t group[kRedundantCopies];
+        if (slotGroup(store, entrySlot(observed), group) > 1) break;
+        if (observed & kWriteBit) {
+            sched_yield();
+            continue;
+        }
+
+        ValueSlot* slot = slotAt(store, group[0]);
+        uint64_t key = slot->key.load(std::memory_order_relaxed);
+        uint64_t masked = slot->masked.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry->load(std::memory_order_relaxed) != observed) continue;
+
+        // A relocation or another update since the loads fails the CAS
+        uint64_t current = masked ^ key;
+        uint64_t next = current;
+        if (!compute(current, &next) ||
+            slot->masked.compare_exchange_weak(masked, next ^ key, std::memory_order_release,
+                                               std::memory_order_relaxed)) {
+            if (before) *before = current;
+            if (after) *after = next;
+            return true;
+        }
+    }
+
+    // Redundant: vote, then rewrite every copy under the write bit
+    uint64_t locked = lockEntry(entry);
+    uint32_t group[kRedundantCopies];
+    int count = slotGroup(store, entrySlot(locked), group);
+    uint64_t current = voteLocked(store, group, count);
+    uint64_t next = current;
+    if (compute(current, &next)) {
+        for (int i = 0; i < count; i++) {
+            writeCopy(store, group[i], next);
+        }
+    }
+    entry->store(makeEntry(entrySlot(locked), locked), std::memory_order_release);
+
+    if (before) *before = current;
+    if (after) *after = next;
+    return true;
+}
+
+bool valueStoreSet(ValueStore& store, int64_t handle, uint64_t bits, uint64_t* before) {
+    return updateEntry(store, handle, [bits](uint64_t, uint64_t* next) {
+        *next = bits;
+        return true;
+    }, before, nullptr);
+}
+
+bool valueStoreUpdate(ValueStore& store, int64_t handle, ValueUpdate update, const void* arg,
+                      uint64_t* before, uint64_t* after) {
+    return updateEntry(store, handle, [update, arg](uint64_t current, uint64_t* next) {
+        return update(current, arg, next);
+    }, before, after);
+}
+
+size_t valueStoreRelocate(ValueStore& store, int64_t budgetNs) {
+    std::lock_guard<std::mutex> lock(store.mutex);
+
+    size_t count = store.entryCount.load(std::memory_order_relaxed);
+    if (count == 0) return 0;
+
+    int64_t deadline = monotonicNs() + budgetNs;
+    size_t moved = 0;
+
+    for (size_t n = 0; n < count; n++) {
+        if (n % kRelocateClockStride == 0 && monotonicNs() >= deadline) break;
+
+        size_t index = store.relocateCursor % count;
+        store.relocateCursor = index + 1;
+
+        // Only this pass moves values, so the slot group cannot change
+        // under us; allocate before locking to keep updates waiting briefly
+        std::atomic<uint64_t>* entry = entryAt(store, static_cast<int64_t>(index) + 1);
+        uint32_t from[kRedundantCopies];
+        int copies = slotGroup(store, entrySlot(entry->load(std::memory_order_relaxed)), from);
+
+        uint32_t to[kRedundantCopies];
+        if (!allocateGroup(store, copies, to)) break;
+
+        uint64_t current = lockEntry(entry);
+
+        // Vote (and count any fault) before re-masking under the new keys
+        uint64_t bits = copies == 1 ? retireCopy(store, from[0]) : voteLocked(store, from, copies);
+        fillGroup(store, to, copies, bits);
+        entry->store(makeEntry(to[0], current), std::memory_order_release);
+
+        // Safe to recycle at once: readers validate the entry version
+        for (int i = 0; i < copies; i++) {
+            releaseSlot(store, from[i]);
+        }
+        moved++;
+    }
+
+    store.relocations += moved;
+    return moved;
+}
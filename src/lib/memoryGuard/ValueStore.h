@@ -0,0 +1,92 @@
+#ifndef STFU_VALUE_STORE_H
+#define STFU_VALUE_STORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Storage for protected scalar values.
+//
+// Java holds an opaque handle that indexes a handle table; each table entry
+// points at a slot holding the value XOR-masked with a per-slot key. A
+// relocation pass periodically moves values to randomly chosen free slots
+// under fresh keys, so an address found by a memory search goes stale.
+//
+// Entries pack (slot index, version, write bit) into one word. Readers never
+// lock: they read the slot and re-check that the entry still names the same
+// slot version. Slot chunks are type-stable (recycled, never unmapped) so a
+// reader racing a relocation always touches mapped memory.
+//
+// Sets and read-modify-writes of single values are lock-free: each is one
+// compare-and-swap on the masked word, validated against the entry like a
+// read, and retried only when another thread's update won. To move a value
+// the relocator takes the entry's write bit and flips the old masked word
+// with an atomic XOR, which both reads the final value and fails every CAS
+// still aimed at the old slot. Those updates retry on the new slot once the
+// entry is republished a few stores later; allocation happens beforehand.
+//
+// Redundant values keep kRedundantCopies copies, each in its own slot on its
+// own page under its own key. Reads take a bitwise majority; a copy that
+// disagrees on a stable read is counted as a fault and rewritten. Writes
+// to redundant values serialize on the write bit, since three copies cannot
+// change in one CAS.
+
+constexpr size_t kSlotsPerChunk = 128;
+constexpr size_t kMaxSlotChunks = 8192;
+constexpr size_t kEntriesPerChunk = 1024;
+constexpr size_t kMaxEntryChunks = 1024;
+constexpr int kRedundantCopies = 3;
+
+// Key and replicas are fixed for the life of a slot
+struct alignas(32) ValueSlot {
+    std::atomic<uint64_t> masked;
+    std::atomic<uint64_t> key;
+    std::atomic<uint64_t> replicas; // Two more slot indices, or kNoReplicas
+    uint64_t reserved;
+};
+
+struct ValueStore {
+    std::atomic<ValueSlot*> slotChunks[kMaxSlotChunks] = {};
+    std::atomic<std::atomic<uint64_t>*> entryChunks[kMaxEntryChunks] = {};
+    std::atomic<uint32_t> entryCount{0};
+    std::atomic<uint64_t> redundancyFaults{0};
+
+    // Guarded by mutex: allocation, free list and relocation cursor
+    std::mutex mutex;
+    std::vector<uint32_t> freeSlots;
+    size_t slotChunkCount = 0;
+    size_t slotsInUse = 0;
+    size_t relocateCursor = 0;
+    uint64_t rngState = 0;
+    uint64_t relocations = 0;
+};
+
+void valueStoreInit(ValueStore& store, uint64_t seed);
+void valueStoreDestroy(ValueStore& store);
+
+// Returns a handle for a new value, or 0 when the store is full
+int64_t valueStoreCreate(ValueStore& store, uint64_t bits, bool redundant);
+
+// Reads of redundant values may repair a disagreeing copy
+bool valueStoreGet(ValueStore& store, int64_t handle, uint64_t* bits);
+// *before, if given, receives the value that was replaced
+bool valueStoreSet(ValueStore& store, int64_t handle, uint64_t bits, uint64_t* before = nullptr);
+
+// Computes the next value from the current one. Return false to leave the
+// value unchanged (a failed compare, a rejected bound).
+typedef bool (*ValueUpdate)(uint64_t bits, const void* arg, uint64_t* next);
+
+// Atomic read-modify-write, linearizable with every get, set and update.
+// Under contention `update` may run more than once, so it must not have side
+// effects. *before receives the value the applied call saw and *after the
+// value it left. Returns false for unknown handles.
+bool valueStoreUpdate(ValueStore& store, int64_t handle, ValueUpdate update, const void* arg,
+                      uint64_t* before, uint64_t* after);
+
+// Relocate values until budgetNs has elapsed, resuming where the last pass
+// stopped. Returns the number of values moved.
+size_t valueStoreRelocate(ValueStore& store, int64_t budgetNs);
+
+#endif // STFU_VALUE_STORE_H
@@ -0,0 +1,399 @@
+#include "Vault.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sched.h>
+#include <sys/mman.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <wmmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+// Lines whose keystream is produced per call: one ChaCha20 block per vector
+// lane, or four lines of four interleaved AES blocks
+constexpr size_t kVaultBatchLines = 4;
+
+constexpr size_t kAesBlocksPerLine = kVaultLineSize / 16;
+
+typedef void (*KeystreamFn)(const VaultKey& key, size_t line, const uint32_t* generations,
+                            size_t count, uint8_t* out);
+
+// Only needed for the key schedule; the hardware paths do the rounds
+static const uint8_t SBOX[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+
+static void expandAesKey(const uint8_t key[16], uint8_t roundKeys[11][16]) {
+    static const uint8_t RCON[10] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36};
+
+    memcpy(roundKeys[0], key, 16);
+    for (int r = 1; r <= 10; r++) {
+        const uint8_t* prev = roundKeys[r - 1];
+        uint8_t* next = roundKeys[r];
+        next[0] = prev[0] ^ SBOX[prev[13]] ^ RCON[r - 1];
+        next[1] = prev[1] ^ SBOX[prev[14]];
+        next[2] = prev[2] ^ SBOX[prev[15]];
+        next[3] = prev[3] ^ SBOX[prev[12]];
+        for (int i = 4; i < 16; i++) {
+            next[i] = prev[i] ^ next[i - 4];
+        }
+    }
+}
+
+// AES counter blocks of a line are (line * 4 + j, nonce ^ generation),
+// stored as two little-endian 64-bit words
+static inline uint64_t aesCounterLo(size_t line) {
+    return static_cast<uint64_t>(line) * kAesBlocksPerLine;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("aes,sse2")))
+static void aesniKeystream(const VaultKey& key, size_t line, const uint32_t* generations,
+                           size_t count, uint8_t* out) {
+    __m128i rk[11];
+    for (int r = 0; r < 11; r++) {
+        rk[r] = _mm_load_si128(reinterpret_cast<const __m128i*>(key.aesRoundKeys[r]));
+    }
+
+    // A line's four blocks go through each round together, kept in registers;
+    // successive lines are independent, so the core overlaps them as well
+    for (size_t l = 0; l < count; l++) {
+        long long hi = static_cast<long long>(key.nonce ^ generations[l]);
+        long long lo = static_cast<long long>(aesCounterLo(line + l));
+        __m128i b0 = _mm_xor_si128(_mm_set_epi64x(hi, lo), rk[0]);
+        __m128i b1 = _mm_xor_si128(_mm_set_epi64x(hi, lo + 1), rk[0]);
+        __m128i b2 = _mm_xor_si128(_mm_set_epi64x(hi, lo + 2), rk[0]);
+        __m128i b3 = _mm_xor_si128(_mm_set_epi64x(hi, lo + 3), rk[0]);
+        for (int r = 1; r < 10; r++) {
+            b0 = _mm_aesenc_si128(b0, rk[r]);
+            b1 = _mm_aesenc_si128(b1, rk[r]);
+            b2 = _mm_aesenc_si128(b2, rk[r]);
+            b3 = _mm_aesenc_si128(b3, rk[r]);
+        }
+
+        __m128i* dst = reinterpret_cast<__m128i*>(out + l * kVaultLineSize);
+        _mm_storeu_si128(dst + 0, _mm_aesenclast_si128(b0, rk[10]));
+        _mm_storeu_si128(dst + 1, _mm_aesenclast_si128(b1, rk[10]));
+        _mm_storeu_si128(dst + 2, _mm_aesenclast_si128(b2, rk[10]));
+        _mm_storeu_si128(dst + 3, _mm_aesenclast_si128(b3, rk[10]));
+    }
+}
+
+#elif defined(__aarch64__)
+
+#if defined(__clang__)
+__attribute__((target("crypto")))
+#else
+__attribute__((target("+crypto")))
+#endif
+static void armAesKeystream(const VaultKey& key, size_t line, const uint32_t* generations,
+                            size_t count, uint8_t* out) {
+    uint8x16_t rk[11];
+    for (int r = 0; r < 11; r++) {
+        rk[r] = vld1q_u8(key.aesRoundKeys[r]);
+    }
+
+    // AESE folds in the round key before SubBytes, so round r uses rk[r]
+    for (size_t l = 0; l < count; l++) {
+        uint64x1_t hi = vcreate_u64(key.nonce ^ generations[l]);
+        uint64_t lo = aesCounterLo(line + l);
+        uint8x16_t b0 = vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(lo), hi));
+        uint8x16_t b1 = vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(lo + 1), hi));
+        uint8x16_t b2 = vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(lo + 2), hi));
+        uint8x16_t b3 = vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(lo + 3), hi));
+        for (int r = 0; r < 9; r++) {
+            b0 = vaesmcq_u8(vaeseq_u8(b0, rk[r]));
+            b1 = vaesmcq_u8(vaeseq_u8(b1, rk[r]));
+            b2 = vaesmcq_u8(vaeseq_u8(b2, rk[r]));
+            b3 = vaesmcq_u8(vaeseq_u8(b3, rk[r]));
+        }
+
+        uint8_t* dst = out + l * kVaultLineSize;
+        vst1q_u8(dst + 0, veorq_u8(vaeseq_u8(b0, rk[9]), rk[10]));
+        vst1q_u8(dst + 16, veorq_u8(vaeseq_u8(b1, rk[9]), rk[10]));
+        vst1q_u8(dst + 32, veorq_u8(vaeseq_u8(b2, rk[9]), rk[10]));
+        vst1q_u8(dst + 48, veorq_u8(vaeseq_u8(b3, rk[9]), rk[10]));
+    }
+}
+
+#endif
+
+// Four 32-bit lanes, one line per lane; lowers to NEON on arm64 and SSE2 on x86
+typedef uint32_t VaultLanes __attribute__((vector_size(16)));
+
+static inline VaultLanes rotl(VaultLanes x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+static inline void quarterRound(VaultLanes& a, VaultLanes& b, VaultLanes& c, VaultLanes& d) {
+    a += b; d = rotl(d ^ a, 16);
+    c += d; b = rotl(b ^ c, 12);
+    a += b; d = rotl(d ^ a, 8);
+    c += d; b = rotl(b ^ c, 7);
+}
+
+// ChaCha20 (RFC 8439 layout): block counter = line, nonce = (generation, vault nonce)
+static void chachaKeystream(const VaultKey& key, size_t line, const uint32_t* generations,
+                            size_t count, uint8_t* out) {
+    static const uint32_t SIGMA[4] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574};
+
+    VaultLanes in[16];
+    for (int i = 0; i < 4; i++) {
+        in[i] = VaultLanes{SIGMA[i], SIGMA[i], SIGMA[i], SIGMA[i]};
+    }
+    for (int i = 0; i < 8; i++) {
+        uint32_t k = key.chachaKey[i];
+        in[4 + i] = VaultLanes{k, k, k, k};
+    }
+    for (size_t lane = 0; lane < kVaultBatchLines; lane++) {
+        in[12][lane] = static_cast<uint32_t>(line + lane);
+        in[13][lane] = lane < count ? generations[lane] : 0;
+    }
+    uint32_t nonceLo = static_cast<uint32_t>(key.nonce);
+    uint32_t nonceHi = static_cast<uint32_t>(key.nonce >> 32);
+    in[14] = VaultLanes{nonceLo, nonceLo, nonceLo, nonceLo};
+    in[15] = VaultLanes{nonceHi, nonceHi, nonceHi, nonceHi};
+
+    // Named state words stay in vector registers through the rounds
+    VaultLanes x0 = in[0], x1 = in[1], x2 = in[2], x3 = in[3];
+    VaultLanes x4 = in[4], x5 = in[5], x6 = in[6], x7 = in[7];
+    VaultLanes x8 = in[8], x9 = in[9], x10 = in[10], x11 = in[11];
+    VaultLanes x12 = in[12], x13 = in[13], x14 = in[14], x15 = in[15];
+    for (int r = 0; r < 10; r++) {
+        quarterRound(x0, x4, x8, x12);
+        quarterRound(x1, x5, x9, x13);
+        quarterRound(x2, x6, x10, x14);
+        quarterRound(x3, x7, x11, x15);
+        quarterRound(x0, x5, x10, x15);
+        quarterRound(x1, x6, x11, x12);
+        quarterRound(x2, x7, x8, x13);
+        quarterRound(x3, x4, x9, x14);
+    }
+    const VaultLanes x[16] = {
+        x0 + in[0], x1 + in[1], x2 + in[2], x3 + in[3],
+        x4 + in[4], x5 + in[5], x6 + in[6], x7 + in[7],
+        x8 + in[8], x9 + in[9], x10 + in[10], x11 + in[11],
+        x12 + in[12], x13 + in[13], x14 + in[14], x15 + in[15],
+    };
+
+    // Transpose 4x4 word tiles so each line's keystream is contiguous
+    uint8_t lines[kVaultBatchLines * kVaultLineSize];
+    for (int q = 0; q < 4; q++) {
+        VaultLanes lo01 = __builtin_shufflevector(x[4 * q], x[4 * q + 1], 0, 4, 1, 5);
+        VaultLanes hi01 = __builtin_shufflevector(x[4 * q], x[4 * q + 1], 2, 6, 3, 7);
+        VaultLanes lo23 = __builtin_shufflevector(x[4 * q + 2], x[4 * q + 3], 0, 4, 1, 5);
+        VaultLanes hi23 = __builtin_shufflevector(x[4 * q + 2], x[4 * q + 3], 2, 6, 3, 7);
+
+        VaultLanes l0 = __builtin_shufflevector(lo01, lo23, 0, 1, 4, 5);
+        VaultLanes l1 = __builtin_shufflevector(lo01, lo23, 2, 3, 6, 7);
+        VaultLanes l2 = __builtin_shufflevector(hi01, hi23, 0, 1, 4, 5);
+        VaultLanes l3 = __builtin_shufflevector(hi01, hi23, 2, 3, 6, 7);
+        memcpy(lines + 0 * kVaultLineSize + 16 * q, &l0, 16);
+        memcpy(lines + 1 * kVaultLineSize + 16 * q, &l1, 16);
+        memcpy(lines + 2 * kVaultLineSize + 16 * q, &l2, 16);
+        memcpy(lines + 3 * kVaultLineSize + 16 * q, &l3, 16);
+    }
+    memcpy(out, lines, count * kVaultLineSize);
+}
+
+static KeystreamFn selectKeystream(VaultCipherKind* kind) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("aes")) {
+        *kind = VAULT_CIPHER_AES128;
+        return aesniKeystream;
+    }
+#elif defined(__aarch64__)
+    if (getauxval(AT_HWCAP) & HWCAP_AES) {
+        *kind = VAULT_CIPHER_AES128;
+        return armAesKeystream;
+    }
+#endif
+    *kind = VAULT_CIPHER_CHACHA20;
+    return chachaKeystream;
+}
+
+static VaultCipherKind g_cipherKind;
+static const KeystreamFn g_keystream = selectKeystream(&g_cipherKind);
+
+VaultCipherKind vaultCipher() {
+    return g_cipherKind;
+}
+
+static inline void xorBytes(uint8_t* dst, const uint8_t* a, const uint8_t* b, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t x, y;
+        memcpy(&x, a + i, 8);
+        memcpy(&y, b + i, 8);
+        x ^= y;
+        memcpy(dst + i, &x, 8);
+    }
+    for (; i < n; i++) {
+        dst[i] = a[i] ^ b[i];
+    }
+}
+
+static bool rangeInVault(const Vault& vault, size_t offset, size_t size) {
+    return vault.data && size != 0 && offset <= vault.size && size <= vault.size - offset;
+}
+
+bool vaultCreate(Vault& vault, size_t size, const uint32_t key[8], uint64_t nonce) {
+    if (size == 0) return false;
+
+    size_t lines = (size + kVaultLineSize - 1) / kVaultLineSize;
+    void* data = mmap(nullptr, lines * kVaultLineSize, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) return false;
+
+    vault.data = static_cast<uint8_t*>(data);
+    vault.size = size;
+    vault.lineCount = lines;
+    vault.generation.reset(new std::atomic<uint32_t>[lines]);
+
+    memcpy(vault.key.chachaKey, key, sizeof(vault.key.chachaKey));
+    uint8_t aesKey[16];
+    memcpy(aesKey, key, sizeof(aesKey));
+    expandAesKey(aesKey, vault.key.aesRoundKeys);
+    vault.key.nonce = nonce;
+
+    // Encrypt the initial zeros so no line is ever plaintext
+    uint8_t stream[kVaultBatchLines * kVaultLineSize];
+    uint32_t generations[kVaultBatchLines] = {0};
+    for (size_t line = 0; line < lines; line += kVaultBatchLines) {
+        size_t count = std::min(kVaultBatchLines, lines - line);
+        g_keystream(vault.key, line, generations, count, stream);
+        memcpy(vault.data + line * kVaultLineSize, stream, count * kVaultLineSize);
+        for (size_t i = 0; i < count; i++) {
+            vault.generation[line + i].store(0, std::memory_order_relaxed);
+        }
+    }
+    return true;
+}
+
+void vaultDestroy(Vault& vault) {
+    if (!vault.data) return;
+
+    munmap(vault.data, vault.lineCount * kVaultLineSize);
+    vault.data = nullptr;
+    vault.size = 0;
+    vault.lineCount = 0;
+    vault.generation.reset();
+    memset(&vault.key, 0, sizeof(vault.key));
+}
+
+bool vaultRead(Vault& vault, size_t offset, void* out, size_t size) {
+    if (!rangeInVault(vault, offset, size)) return false;
+
+    uint8_t* dst = static_cast<uint8_t*>(out);
+    size_t end = offset + size;
+    size_t last = (end - 1) / kVaultLineSize;
+
+    for (size_t line = offset / kVaultLineSize; line <= last; line += kVaultBatchLines) {
+        size_t count = std::min(kVaultBatchLines, last - line + 1);
+        size_t from = std::max(offset, line * kVaultLineSize);
+        size_t to = std::min(end, (line + count) * kVaultLineSize);
+        size_t skip = from - line * kVaultLineSize;
+
+        for (;;) {
+            uint32_t generations[kVaultBatchLines];
+            bool busy = false;
+            for (size_t i = 0; i < count; i++) {
+                generations[i] = vault.generation[line + i].load(std::memory_order_acquire);
+                busy |= (generations[i] & 1) != 0;
+            }
+            if (busy) {
+                sched_yield();
+                continue;
+            }
+
+            uint8_t stream[kVaultBatchLines * kVaultLineSize];
+            g_keystream(vault.key, line, generations, count, stream);
+            xorBytes(dst + (from - offset), vault.data + from, stream + skip, to - from);
+
+            // Retry the batch if a writer re-encrypted any of its lines meanwhile
+            std::atomic_thread_fence(std::memory_order_acquire);
+            bool stable = true;
+            for (size_t i = 0; i < count; i++) {
+                stable &= vault.generation[line + i].load(std::memory_order_relaxed) == generations[i];
+            }
+            if (stable) break;
+        }
+    }
+    return true;
+}
+
+bool vaultWrite(Vault& vault, size_t offset, const void* data, size_t size) {
+    if (!rangeInVault(vault, offset, size)) return false;
+
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    size_t end = offset + size;
+    size_t last = (end - 1) / kVaultLineSize;
+
+    for (size_t line = offset / kVaultLineSize; line <= last; line += kVaultBatchLines) {
+        size_t count = std::min(kVaultBatchLines, last - line + 1);
+        size_t base = line * kVaultLineSize;
+        size_t from = std::max(offset, base);
+        size_t to = std::min(end, base + count * kVaultLineSize);
+
+        // Take the lines in ascending order so overlapping writers can't deadlock
+        uint32_t generations[kVaultBatchLines];
+        for (size_t i = 0; i < count; i++) {
+            std::atomic<uint32_t>& generation = vault.generation[line + i];
+            uint32_t current = generation.load(std::memory_order_relaxed);
+            for (;;) {
+                if (current & 1) {
+                    sched_yield();
+                    current = generation.load(std::memory_order_relaxed);
+                } else if (generation.compare_exchange_weak(current, current + 1,
+                                                            std::memory_order_acquire,
+                                                            std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            generations[i] = current;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+
+        // Lines only partly overwritten keep their other bytes
+        uint8_t plain[kVaultBatchLines * kVaultLineSize];
+        uint8_t stream[kVaultBatchLines * kVaultLineSize];
+        size_t bytes = count * kVaultLineSize;
+        if (from != base || to != base + bytes) {
+            g_keystream(vault.key, line, generations, count, stream);
+            xorBytes(plain, vault.data + base, stream, bytes);
+        }
+        memcpy(plain + (from - base), src + (from - offset), to - from);
+
+        for (size_t i = 0; i < count; i++) {
+            generations[i] += 2;
+        }
+        g_keystream(vault.key, line, generations, count, stream);
+        xorBytes(vault.data + base, plain, stream, bytes);
+        memset(plain, 0, sizeof(plain));
+
+        for (size_t i = 0; i < count; i++) {
+            vault.generation[line + i].store(generations[i], std::memory_order_release);
+        }
+    }
+    return true;
+}
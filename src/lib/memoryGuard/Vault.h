@@ -0,0 +1,56 @@
+#ifndef STFU_VAULT_H
+#define STFU_VAULT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Encrypted-at-rest storage for large game-state blobs.
+//
+// Vault bytes are only ever held as CTR-mode ciphertext, so a memory scanner
+// sees noise. Every 64-byte line is encrypted on its own, with a counter made
+// of the line index and a per-line generation that each write bumps, so a
+// rewritten line never reuses keystream. Accessors decrypt just the lines
+// they touch, producing keystream for several lines per batch.
+//
+// AES-128 is used when the CPU has AES instructions (ARMv8 Crypto Extensions
+// or AES-NI), ChaCha20 otherwise; ciphertext never leaves the process, so
+// the choice is made once at runtime and is invisible to callers.
+//
+// Line generations double as seqlocks: writers hold them odd while they
+// re-encrypt a line and readers retry lines whose generation moved.
+
+constexpr size_t kVaultLineSize = 64;
+
+enum VaultCipherKind {
+    VAULT_CIPHER_CHACHA20 = 0,
+    VAULT_CIPHER_AES128 = 1,
+};
+
+struct VaultKey {
+    alignas(16) uint8_t aesRoundKeys[11][16];
+    uint32_t chachaKey[8];
+    uint64_t nonce;
+};
+
+struct Vault {
+    uint8_t* data; // Ciphertext, own mapping of whole lines
+    size_t size;
+    size_t lineCount;
+    std::unique_ptr<std::atomic<uint32_t>[]> generation;
+    VaultKey key;
+};
+
+// Cipher used on this CPU
+VaultCipherKind vaultCipher();
+
+// Set up a vault of `size` zero bytes under a fresh 256-bit key and nonce
+bool vaultCreate(Vault& vault, size_t size, const uint32_t key[8], uint64_t nonce);
+void vaultDestroy(Vault& vault);
+
+// Plaintext access to [offset, offset + size); false if out of range
+bool vaultRead(Vault& vault, size_t offset, void* out, size_t size);
+bool vaultWrite(Vault& vault, size_t offset, const void* data, size_t size);
+
+#endif // STFU_VAULT_H